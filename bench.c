@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gameboy.h"
+
+// CPU micro-benchmarks, built with make bench and run as ./bench [workload] [instructions]. The Makefile's CFLAGS
+// have no optimisation, pass -O2 in them for numbers worth comparing.
+// Each workload is a fixed instruction stream at 0x150 of an otherwise empty ROM that jumps back to its start.
+// Most are run through updateCPU alone, so the PPU, the timer and the rest of updateHardware stay out of the numbers.
+// The loop workloads go through runCPU instead, with the block cache on and the JIT and idle loop skipping off,
+// as that is where fusion happens. They count machine cycles rather than instructions.
+
+#define BENCH_ENTRY 0x150
+#define BENCH_RUNS 5
+
+typedef enum BenchCore {
+    CORE_UPDATE_CPU,
+    CORE_THREADED,
+    CORE_FUSED
+} BenchCore;
+
+typedef struct Workload {
+    const char* name;
+    const char* description;
+    const uint8_t* code;
+    size_t length;
+    BenchCore core;
+} Workload;
+
+// 8-bit ALU, rotates and flag readers, what every handler setting or reading Z/N/H/C pays for
+static const uint8_t aluCode[] = {
+    0x80,             // ADD A, B
+    0x89,             // ADC A, C
+    0x92,             // SUB A, D
+    0x9b,             // SBC A, E
+    0xa4,             // AND A, H
+    0xad,             // XOR A, L
+    0xb0,             // OR A, B
+    0xb9,             // CP A, C
+    0x3c,             // INC A
+    0x05,             // DEC B
+    0xc6, 0x37,       // ADD A, u8
+    0xde, 0x11,       // SBC A, u8
+    0xcb, 0x11,       // RL C
+    0xcb, 0x3a,       // SRL D
+    0xcb, 0x5b,       // BIT 3, E
+    0xcb, 0x37,       // SWAP A
+    0x0c,             // INC C
+    0x1d,             // DEC E
+    0x27,             // DAA
+    0x17,             // RLA
+    0xc3, 0x50, 0x01  // JP 0x150
+};
+
+// BC, DE and HL used as pairs: loads and stores through them, increments, 16-bit adds and the stack
+static const uint8_t pairsCode[] = {
+    0x21, 0x00, 0xd0, // LD HL, 0xd000
+    0x01, 0x00, 0xd1, // LD BC, 0xd100
+    0x11, 0x00, 0xd2, // LD DE, 0xd200
+    0x2a,             // LD A, (HL+)
+    0x22,             // LD (HL+), A
+    0x3a,             // LD A, (HL-)
+    0x32,             // LD (HL-), A
+    0x02,             // LD (BC), A
+    0x1a,             // LD A, (DE)
+    0x03,             // INC BC
+    0x1b,             // DEC DE
+    0x23,             // INC HL
+    0x2b,             // DEC HL
+    0xc5,             // PUSH BC
+    0xd1,             // POP DE
+    0xe5,             // PUSH HL
+    0xc1,             // POP BC
+    0x09,             // ADD HL, BC
+    0x19,             // ADD HL, DE
+    0x29,             // ADD HL, HL
+    0xf8, 0x02,       // LD HL, SP + 2
+    0xc3, 0x50, 0x01  // JP 0x150
+};
+
+// The loops fusions.inc is there for: a copy counted down in BC, a fill counted in B, a delay and a STAT poll
+static const uint8_t loopsCode[] = {
+    0x21, 0x00, 0xc0, // LD HL, 0xc000
+    0x11, 0x00, 0xd0, // LD DE, 0xd000
+    0x01, 0x00, 0x01, // LD BC, 0x0100
+    0x2a,             // LD A, (HL+)
+    0x12,             // LD (DE), A
+    0x13,             // INC DE
+    0x0b,             // DEC BC
+    0x78,             // LD A, B
+    0xb1,             // OR A, C
+    0x20, 0xf8,       // JR NZ, 0x159
+    0x21, 0x00, 0xc0, // LD HL, 0xc000
+    0x06, 0x00,       // LD B, 0
+    0x22,             // LD (HL+), A
+    0x05,             // DEC B
+    0x20, 0xfc,       // JR NZ, 0x166
+    0x3e, 0x40,       // LD A, 0x40
+    0x3d,             // DEC A
+    0x20, 0xfd,       // JR NZ, 0x16c
+    0xf0, 0x41,       // LDH A, (STAT)
+    0xe6, 0x03,       // AND A, 3
+    0x20, 0xfa,       // JR NZ, 0x16f
+    0xc3, 0x50, 0x01  // JP 0x150
+};
+
+static const Workload workloads[] = {
+    { "alu", "8-bit ALU and flags", aluCode, sizeof(aluCode), CORE_UPDATE_CPU },
+    { "pairs", "16-bit register pairs", pairsCode, sizeof(pairsCode), CORE_UPDATE_CPU },
+    { "loops", "copy, fill and poll loops", loopsCode, sizeof(loopsCode), CORE_THREADED },
+    { "fused", "the same loops, fused", loopsCode, sizeof(loopsCode), CORE_FUSED }
+};
+
+#define WORKLOAD_COUNT ((int) (sizeof(workloads) / sizeof(workloads[0])))
+
+static double getSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void freeBenchGameBoy(GameBoy* gameBoy) {
+    freeBlockCache(&gameBoy->blockCache);
+    freeSaveRAM(&gameBoy->saveRAM);
+    freeGameBoy(gameBoy);
+}
+
+// A cartridge without an MBC or RAM, the stream in its first bank and everything else zeroed
+static GameBoy* createBenchGameBoy(uint8_t* rom, const Workload* workload) {
+    GameBoy* gameBoy = allocateGameBoy();
+    if(gameBoy == NULL)
+        return NULL;
+    memcpy(&rom[BENCH_ENTRY], workload->code, workload->length);
+    gameBoy->cartridge.data = rom;
+    gameBoy->cartridge.romBankCount = 2;
+    gameBoy->mapper = getMapper(0x00);
+    gameBoy->currentROMBank = 1;
+    gameBoy->ramBankCount = 1;
+    if(!initSaveRAM(&gameBoy->saveRAM, NULL, RAM_BANK_SIZE, 0, false)) {
+        freeGameBoy(gameBoy);
+        return NULL;
+    }
+    updateBanks(gameBoy);
+    mapMemory(gameBoy);
+    if(workload->core == CORE_UPDATE_CPU)
+        return gameBoy;
+    // Everything else allocateGameBoy left zeroed, the JIT and the instruments included, stays off
+    if(!initBlockCache(&gameBoy->blockCache)) {
+        freeBenchGameBoy(gameBoy);
+        return NULL;
+    }
+    initFusion(&gameBoy->fusion, workload->core == CORE_FUSED);
+    initIO(gameBoy);
+    initScheduler(&gameBoy->scheduler);
+    // The LCD stays off so rendering does not swamp the numbers, the timer at its fastest gives events to run
+    writeToMemory(gameBoy, TAC, 0x05);
+    return gameBoy;
+}
+
+static void resetCPU(GameBoy* gameBoy) {
+    memset(&gameBoy->cpu, 0, sizeof(CPU));
+    gameBoy->cpu.pc = BENCH_ENTRY;
+    gameBoy->cpu.sp = 0xdffe;
+}
+
+// Machine cycles, runCPU works in clock cycles
+static uint64_t runThreaded(GameBoy* gameBoy, const long machineCycles) {
+    uint64_t cycles = 0;
+    while(cycles < (uint64_t) machineCycles * 4)
+        cycles += runCPU(gameBoy, CYCLES_PER_FRAME);
+    return cycles / 4;
+}
+
+// The fastest of BENCH_RUNS runs, the others only add scheduling noise
+static bool runWorkload(const Workload* workload, const long instructions) {
+    uint8_t* rom = calloc(1, 2 * ROM_BANK_SIZE);
+    GameBoy* gameBoy = (rom != NULL) ? createBenchGameBoy(rom, workload) : NULL;
+    if(gameBoy == NULL) {
+        free(rom);
+        return false;
+    }
+    double best = 0;
+    uint64_t cycles = 0;
+    for(int run = 0; run < BENCH_RUNS; run++) {
+        resetCPU(gameBoy);
+        cycles = 0;
+        double start = getSeconds();
+        if(workload->core != CORE_UPDATE_CPU)
+            cycles = runThreaded(gameBoy, instructions);
+        else
+            for(long i = 0; i < instructions; i++)
+                cycles += updateCPU(gameBoy);
+        double elapsed = getSeconds() - start;
+        if((run == 0) || (elapsed < best))
+            best = elapsed;
+    }
+    if(workload->core != CORE_UPDATE_CPU)
+        printf("%-8s %-28s %llu machine cycles in %.3f s, %.1f M machine cycles/s, %.2f ns each\n",
+            workload->name, workload->description, (unsigned long long) cycles, best, cycles / best / 1e6, best * 1e9 / cycles);
+    else
+        printf("%-8s %-28s %ld instructions (%llu machine cycles) in %.3f s, %.1f M instructions/s, %.2f ns each\n",
+            workload->name, workload->description, instructions, (unsigned long long) cycles, best,
+            instructions / best / 1e6, best * 1e9 / instructions);
+    freeBenchGameBoy(gameBoy);
+    free(rom);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    const char* name = (argc > 1) ? argv[1] : NULL;
+    long instructions = (argc > 2) ? atol(argv[2]) : 50000000;
+    if(instructions <= 0) {
+        fprintf(stderr, "usage: %s [workload] [instructions]\n", argv[0]);
+        return 1;
+    }
+    bool found = false;
+    for(int i = 0; i < WORKLOAD_COUNT; i++) {
+        if((name != NULL) && (strcmp(name, "all") != 0) && (strcmp(name, workloads[i].name) != 0))
+            continue;
+        found = true;
+        if(!runWorkload(&workloads[i], instructions)) {
+            fprintf(stderr, "Could not set up %s\n", workloads[i].name);
+            return 1;
+        }
+    }
+    if(!found) {
+        fprintf(stderr, "Unknown workload %s, one of:", name);
+        for(int i = 0; i < WORKLOAD_COUNT; i++)
+            fprintf(stderr, " %s", workloads[i].name);
+        fprintf(stderr, " all\n");
+        return 1;
+    }
+    return 0;
+}
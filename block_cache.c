@@ -0,0 +1,123 @@
+#include "block_cache.h"
+#include <stdlib.h>
+#include "gameboy.h"
+
+static bool endsBlock(const uint8_t opcode) {
+    switch(opcode) {
+        case 0x10: case 0x76: // STOP, HALT
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+        case 0xc2: case 0xc3: case 0xca: case 0xd2: case 0xda: case 0xe9: // JP
+        case 0xc4: case 0xcc: case 0xcd: case 0xd4: case 0xdc: // CALL
+        case 0xc0: case 0xc8: case 0xc9: case 0xd0: case 0xd8: case 0xd9: // RET
+        case 0xc7: case 0xcf: case 0xd7: case 0xdf: case 0xe7: case 0xef: case 0xf7: case 0xff: // RST
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Only ROM, WRAM and HRAM code is cached, everything else is fetched through readFromMemory
+static uint32_t getCodeRegionEnd(const uint16_t address) {
+    if(address < 0x4000)
+        return 0x4000;
+    else if(address < 0x8000)
+        return 0x8000;
+    else if((address >= 0xc000) && (address < 0xe000))
+        return 0xe000;
+    else if((address >= 0xff80) && (address < 0xffff))
+        return 0xffff;
+    return 0;
+}
+
+static uint32_t getBlockIndex(const uint16_t pc, const uint16_t bank) {
+    return (pc ^ (pc >> 11) ^ (bank << 3)) & (BLOCK_CACHE_ENTRIES - 1);
+}
+
+bool initBlockCache(BlockCache* blockCache) {
+    blockCache->blocks = calloc(BLOCK_CACHE_ENTRIES, sizeof(Block));
+    blockCache->epoch = 0;
+    for(int i = 0; i < 0x100; i++)
+        blockCache->codePages[i] = false;
+    return blockCache->blocks != NULL;
+}
+
+void freeBlockCache(BlockCache* blockCache) {
+    free(blockCache->blocks);
+    blockCache->blocks = NULL;
+}
+
+static void decodeBlock(GameBoy* gameBoy, Block* block, const uint16_t pc, const uint16_t bank, const uint32_t regionEnd) {
+    block->pc = pc;
+    block->bank = bank;
+    block->length = 0;
+    block->hits = 0;
+    block->jitCode = NULL;
+    uint32_t address = pc;
+    while(block->length < BLOCK_MAX_INSTRUCTIONS) {
+        // A breakpoint starts a block of its own so runCPU gets to check it
+        if((address != pc) && gameBoy->debugger.enabled && isBreakpoint(&gameBoy->debugger, address))
+            break;
+        uint8_t opcode = peekMemory(gameBoy, address);
+        uint8_t length = instructionLengths[opcode];
+        if(address + length > regionEnd)
+            break;
+        DecodedInstruction* decoded = &block->instructions[block->length++];
+        decoded->pc = address;
+        decoded->opcode = opcode;
+        decoded->handler = opcode;
+        for(int i = 1; i < length; i++)
+            decoded->operands[i - 1] = peekMemory(gameBoy, address + i);
+        if(opcode == 0xcb) {
+            decoded->cycles = cbInstructionTimings[decoded->operands[0]];
+            decoded->branchedCycles = decoded->cycles;
+        } else {
+            decoded->cycles = instructionTimings[opcode];
+            decoded->branchedCycles = branchedInstructionTimings[opcode];
+        }
+        address += length;
+        if(endsBlock(opcode))
+            break;
+    }
+    block->end = address;
+    block->valid = block->length > 0;
+    classifyIdleLoop(block);
+    classifyFusions(gameBoy, block);
+    if(block->valid && (regionEnd > 0x8000))
+        for(uint32_t page = pc >> 8; page <= ((address - 1) >> 8); page++) {
+            gameBoy->blockCache.codePages[page] = true;
+            mapPage(gameBoy, page);
+        }
+}
+
+Block* lookupBlock(GameBoy* gameBoy, const uint16_t pc) {
+    uint32_t regionEnd = getCodeRegionEnd(pc);
+    // Code outside HRAM fetches 0xff while an accurate DMA holds the bus, readFromMemory returns that
+    if((regionEnd == 0) || (gameBoy->dma.active && (pc < 0xff80)))
+        return NULL;
+    uint16_t bank = ((pc >= 0x4000) && (pc < 0x8000)) ? gameBoy->currentROMBank : 0;
+    Block* block = &gameBoy->blockCache.blocks[getBlockIndex(pc, bank)];
+    if(block->valid && (block->pc == pc) && (block->bank == bank))
+        return block;
+    decodeBlock(gameBoy, block, pc, bank, regionEnd);
+    return block->valid ? block : NULL;
+}
+
+void invalidateAllBlocks(GameBoy* gameBoy) {
+    gameBoy->blockCache.epoch++;
+    for(int i = 0; i < BLOCK_CACHE_ENTRIES; i++)
+        gameBoy->blockCache.blocks[i].valid = false;
+}
+
+void invalidateBlocks(GameBoy* gameBoy, const uint16_t address) {
+    uint8_t page = address >> 8;
+    if(!gameBoy->blockCache.codePages[page])
+        return;
+    gameBoy->blockCache.codePages[page] = false;
+    mapPage(gameBoy, page);
+    gameBoy->blockCache.epoch++;
+    for(int i = 0; i < BLOCK_CACHE_ENTRIES; i++) {
+        Block* block = &gameBoy->blockCache.blocks[i];
+        if(block->valid && (block->pc >= 0xc000) && ((block->pc >> 8) <= page) && (((block->end - 1) >> 8) >= page))
+            block->valid = false;
+    }
+}
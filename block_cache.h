@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "jit.h"
+
+typedef struct GameBoy GameBoy;
+
+#define BLOCK_CACHE_ENTRIES 2048
+#define BLOCK_MAX_INSTRUCTIONS 16
+
+typedef struct DecodedInstruction {
+    uint16_t pc;
+    uint8_t opcode;
+    uint8_t operands[2];
+    uint8_t cycles;
+    uint8_t branchedCycles;
+    // Dispatch table index, the opcode or a fused handler when a fused sequence starts here
+    uint16_t handler;
+} DecodedInstruction;
+
+typedef struct Block {
+    uint16_t pc;
+    uint16_t end;
+    uint16_t bank;
+    uint8_t length;
+    bool valid;
+    uint32_t hits;
+    JitBlockFunction jitCode;
+    // Ends in a branch back to its own start and never writes memory, see skipIdleLoop
+    bool idleLoop;
+    // Reads DIV or TIMA, which move on between events
+    bool idleLoopReadsTimer;
+    DecodedInstruction instructions[BLOCK_MAX_INSTRUCTIONS];
+} Block;
+
+typedef struct BlockCache {
+    Block* blocks;
+    // Bumped whenever a cached block may no longer match memory, a running block is abandoned when it changes
+    uint32_t epoch;
+    // One flag per 256 byte page of WRAM (0xc0 - 0xdf) and HRAM (0xff) holding cached code
+    bool codePages[0x100];
+} BlockCache;
+
+bool initBlockCache(BlockCache* blockCache);
+void freeBlockCache(BlockCache* blockCache);
+
+Block* lookupBlock(GameBoy* gameBoy, const uint16_t pc);
+void invalidateBlocks(GameBoy* gameBoy, const uint16_t address);
+void invalidateAllBlocks(GameBoy* gameBoy);
@@ -0,0 +1,131 @@
+#include "cartridge.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "mapper.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define CARTRIDGE_MMAP
+#endif
+
+#define HEADER_END 0x150
+#define ROM_SIZE 0x148
+
+struct CartridgeImage {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    time_t modified;
+    uint8_t* data;
+    size_t length;
+    bool mapped;
+    int references;
+    CartridgeImage* next;
+};
+
+static CartridgeImage* images = NULL;
+
+// Banks the header at 0x148 claims, 0 when the byte is not a known size
+static uint16_t getHeaderBankCount(const uint8_t romSize) { return (romSize <= 0x08) ? (2 << romSize) : 0; }
+
+static CartridgeImage* findImage(const struct stat* info) {
+    for(CartridgeImage* image = images; image != NULL; image = image->next)
+        if((image->device == info->st_dev) && (image->inode == info->st_ino) &&
+            (image->size == info->st_size) && (image->modified == info->st_mtime))
+            return image;
+    return NULL;
+}
+
+// A file that is exactly a power of two banks is mapped as it is, anything else is read into
+// an allocation padded with zeros up to the next power of two so out of range banks stay in bounds
+static bool readImage(CartridgeImage* image, FILE* file, const size_t length) {
+    image->length = length;
+#ifdef CARTRIDGE_MMAP
+    if(length == (size_t) image->size) {
+        void* data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if(data != MAP_FAILED) {
+            image->data = data;
+            image->mapped = true;
+            return true;
+        }
+    }
+#endif
+    image->data = calloc(1, length);
+    image->mapped = false;
+    return (image->data != NULL) && (fread(image->data, 1, image->size, file) == (size_t) image->size);
+}
+
+static void releaseImage(CartridgeImage* image) {
+#ifdef CARTRIDGE_MMAP
+    if(image->mapped) {
+        munmap(image->data, image->length);
+        return;
+    }
+#endif
+    free(image->data);
+}
+
+bool loadCartridge(Cartridge* cartridge, const char* path) {
+    cartridge->data = NULL;
+    cartridge->romBankCount = 0;
+    cartridge->image = NULL;
+    FILE* file = fopen(path, "rb");
+    if(file == NULL)
+        return false;
+    struct stat info;
+    if((fstat(fileno(file), &info) != 0) || (info.st_size < HEADER_END) ||
+        (info.st_size > (off_t) MAX_ROM_BANKS * ROM_BANK_SIZE)) {
+        fclose(file);
+        return false;
+    }
+
+    CartridgeImage* image = findImage(&info);
+    if(image == NULL) {
+        image = calloc(1, sizeof(CartridgeImage));
+        if(image == NULL) {
+            fclose(file);
+            return false;
+        }
+        image->device = info.st_dev;
+        image->inode = info.st_ino;
+        image->size = info.st_size;
+        image->modified = info.st_mtime;
+        uint16_t bankCount = 2;
+        while((off_t) bankCount * ROM_BANK_SIZE < info.st_size)
+            bankCount *= 2;
+        if(!readImage(image, file, (size_t) bankCount * ROM_BANK_SIZE)) {
+            releaseImage(image);
+            free(image);
+            fclose(file);
+            return false;
+        }
+        image->next = images;
+        images = image;
+    }
+    fclose(file);
+
+    image->references++;
+    cartridge->data = image->data;
+    cartridge->romBankCount = image->length / ROM_BANK_SIZE;
+    cartridge->image = image;
+    uint16_t headerBanks = getHeaderBankCount(image->data[ROM_SIZE]);
+    if(headerBanks != cartridge->romBankCount)
+        fprintf(stderr, "ROM header claims %d banks, the file holds %d\n", headerBanks, cartridge->romBankCount);
+    return true;
+}
+
+void freeCartridge(Cartridge* cartridge) {
+    CartridgeImage* image = cartridge->image;
+    cartridge->data = NULL;
+    cartridge->image = NULL;
+    if((image == NULL) || (--image->references > 0))
+        return;
+    for(CartridgeImage** link = &images; *link != NULL; link = &(*link)->next)
+        if(*link == image) {
+            *link = image->next;
+            break;
+        }
+    releaseImage(image);
+    free(image);
+}
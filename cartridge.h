@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct CartridgeImage CartridgeImage;
+
+// A loaded ROM image, read only. Images of the same file are shared by everything that loads it.
+typedef struct Cartridge {
+    const uint8_t* data;
+    // Always a power of two, bank numbers are wrapped with romBankCount - 1
+    uint16_t romBankCount;
+    CartridgeImage* image;
+} Cartridge;
+
+#define MAX_ROM_BANKS 0x200
+
+bool loadCartridge(Cartridge* cartridge, const char* path);
+void freeCartridge(Cartridge* cartridge);
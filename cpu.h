@@ -2,23 +2,46 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 typedef struct GameBoy GameBoy;
 
+// BC, DE and HL alias their two halves so 16 bit ops are a single load or store
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define REGISTER_PAIR(upper, lower) union { uint16_t upper##lower; struct { uint8_t upper, lower; }; }
+#else
+#define REGISTER_PAIR(upper, lower) union { uint16_t upper##lower; struct { uint8_t lower, upper; }; }
+#endif
+
 typedef struct CPU {
-    uint8_t a, b, c, d, e, h, l;
+    uint8_t a;
+    REGISTER_PAIR(b, c);
+    REGISTER_PAIR(d, e);
+    REGISTER_PAIR(h, l);
     uint16_t sp, pc;
-    bool zero, subtract, halfCarry, carry;
+    // Flags are kept as the last result and only worked out when something reads them:
+    // Z is set when the low byte is 0, C is bit 8, N is bit 9 and bits 16-23 hold the
+    // two operands xored together so H is bit 4 of the result ^ the operands
+    uint32_t flags;
     bool halted;
     bool interruptsEnabled;
     bool pendingInterruptEnable;
     bool oneInstructionPassed;
 } CPU;
 
-bool cpuDebug();
+extern const uint8_t instructionTimings[256];
+extern const uint8_t branchedInstructionTimings[256];
+extern const uint8_t cbInstructionTimings[256];
+extern const uint8_t instructionLengths[256];
+extern const char* const instructionMnemonics[256];
+extern const char* const cbInstructionMnemonics[256];
+// Flag behavior as Z, N, H and C, see instructions.inc
+extern const char* const instructionFlags[256];
+extern const char* const cbInstructionFlags[256];
+extern int (*const opcodeHandlers[256])(GameBoy* gameBoy, const uint8_t instruction);
 
-void pop(GameBoy* gameBoy, uint8_t* lower, uint8_t* upper);
-void push(GameBoy* gameBoy, const uint8_t lower, const uint8_t upper);
+void pop(GameBoy* gameBoy, uint16_t* word);
+void push(GameBoy* gameBoy, const uint16_t word);
 
 void jp_from_word(GameBoy* gameBoy, const uint16_t address);
 void jp_from_bytes(GameBoy* gameBoy, const uint8_t lower, const uint8_t upper);
@@ -27,9 +50,23 @@ void jp_from_pc(GameBoy* gameBoy);
 int decodeAndExecute(GameBoy* gameBoy, const uint8_t instruction);
 int decodeAndExecuteCB(GameBoy* gameBoy, const uint8_t instruction);
 
+int finishInstruction(GameBoy* gameBoy, const int cycles);
 int updateCPU(GameBoy* gameBoy);
+int runCPU(GameBoy* gameBoy, const int cycles);
+
+#define FLAG_RESULT_CARRY 0x100
+#define FLAG_RESULT_SUBTRACT 0x200
+#define FLAG_OPERANDS_SHIFT 16
+
+static inline bool getZeroFlag(const CPU* cpu) { return (uint8_t) cpu->flags == 0; }
+static inline bool getSubtractFlag(const CPU* cpu) { return (cpu->flags & FLAG_RESULT_SUBTRACT) != 0; }
+static inline bool getHalfCarryFlag(const CPU* cpu) { return ((cpu->flags ^ (cpu->flags >> FLAG_OPERANDS_SHIFT)) & 0x10) != 0; }
+static inline bool getCarryFlag(const CPU* cpu) { return (cpu->flags & FLAG_RESULT_CARRY) != 0; }
 
+void setFlags(CPU* cpu, const bool zero, const bool subtract, const bool halfCarry, const bool carry);
 void setFFlagsFromByte(CPU* cpu, const uint8_t newF);
 uint8_t getFFlagsAsByte(CPU* cpu);
 
-void printCPU(CPU* cpu);
\ No newline at end of file
+void printCPU(CPU* cpu);
+int disassemble(GameBoy* gameBoy, const uint16_t address, char* text, const size_t size);
+void printInstruction(GameBoy* gameBoy, const uint16_t address);
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "debugger.h"
+#include <stdio.h>
+#include <string.h>
+#include "gameboy.h"
+#include "block_cache.h"
+
+static const char* const stopNames[4] = { "none", "read watchpoint", "write watchpoint", "breakpoint" };
+
+void initDebugger(Debugger* debugger) { memset(debugger, 0, sizeof(Debugger)); }
+
+static void updatePage(GameBoy* gameBoy, const uint8_t page) {
+    Debugger* debugger = &gameBoy->debugger;
+    uint8_t kinds = 0;
+    for(int i = 0; i < debugger->count; i++)
+        if((debugger->watchpoints[i].address >> 8) == page)
+            kinds |= debugger->watchpoints[i].kinds;
+    bool executeChanged = (kinds ^ debugger->pages[page]) & WATCH_EXECUTE;
+    debugger->pages[page] = kinds;
+    debugger->enabled = debugger->count > 0;
+    mapPage(gameBoy, page);
+    // Blocks decoded before the breakpoint existed may run straight over it
+    if(executeChanged)
+        invalidateAllBlocks(gameBoy);
+}
+
+bool addWatchpoint(GameBoy* gameBoy, const uint16_t address, const uint8_t kinds) {
+    Debugger* debugger = &gameBoy->debugger;
+    int i = 0;
+    while((i < debugger->count) && (debugger->watchpoints[i].address != address))
+        i++;
+    if(i == debugger->count) {
+        if(debugger->count == MAX_WATCHPOINTS)
+            return false;
+        debugger->watchpoints[debugger->count++] = (Watchpoint) { address, 0 };
+    }
+    debugger->watchpoints[i].kinds |= kinds;
+    updatePage(gameBoy, address >> 8);
+    return true;
+}
+
+void removeWatchpoint(GameBoy* gameBoy, const uint16_t address, const uint8_t kinds) {
+    Debugger* debugger = &gameBoy->debugger;
+    for(int i = 0; i < debugger->count; i++) {
+        if(debugger->watchpoints[i].address != address)
+            continue;
+        debugger->watchpoints[i].kinds &= ~kinds;
+        if(debugger->watchpoints[i].kinds == 0)
+            debugger->watchpoints[i] = debugger->watchpoints[--debugger->count];
+        updatePage(gameBoy, address >> 8);
+        return;
+    }
+}
+
+// Called by the handlers for accesses to a watched page. The epoch bump ends the running block,
+// runCPU sees the stop when it looks up the next one.
+void checkWatchpoint(GameBoy* gameBoy, const uint16_t address, const uint8_t kind, const uint8_t value) {
+    Debugger* debugger = &gameBoy->debugger;
+    if(debugger->stopReason != STOP_NONE)
+        return;
+    for(int i = 0; i < debugger->count; i++)
+        if((debugger->watchpoints[i].address == address) && (debugger->watchpoints[i].kinds & kind)) {
+            debugger->stopReason = (kind == WATCH_READ) ? STOP_READ : STOP_WRITE;
+            debugger->stopAddress = address;
+            debugger->stopValue = value;
+            gameBoy->blockCache.epoch++;
+            return;
+        }
+}
+
+// Called at block boundaries, true when runCPU has to return
+bool checkBreakpoint(GameBoy* gameBoy) {
+    Debugger* debugger = &gameBoy->debugger;
+    if(debugger->stopReason != STOP_NONE)
+        return true;
+    uint16_t pc = gameBoy->cpu.pc;
+    if(debugger->resuming) {
+        debugger->resuming = false;
+        if(pc == debugger->resumePC)
+            return false;
+    }
+    if(!isBreakpoint(debugger, pc))
+        return false;
+    debugger->stopReason = STOP_EXECUTE;
+    debugger->stopAddress = pc;
+    debugger->stopValue = 0;
+    return true;
+}
+
+void resumeDebugger(Debugger* debugger) {
+    debugger->resuming = debugger->stopReason == STOP_EXECUTE;
+    debugger->resumePC = debugger->stopAddress;
+    debugger->stopReason = STOP_NONE;
+}
+
+void printStop(GameBoy* gameBoy) {
+    Debugger* debugger = &gameBoy->debugger;
+    if(debugger->stopReason == STOP_EXECUTE)
+        printf("Stopped at breakpoint %04x\n", debugger->stopAddress);
+    else
+        printf("Stopped by %s at %04x (value %02x), PC %04x\n", stopNames[debugger->stopReason],
+            debugger->stopAddress, debugger->stopValue, gameBoy->cpu.pc);
+    printInstruction(gameBoy, gameBoy->cpu.pc);
+}
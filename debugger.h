@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct GameBoy GameBoy;
+
+#define MAX_WATCHPOINTS 32
+
+#define WATCH_READ 0x1
+#define WATCH_WRITE 0x2
+#define WATCH_EXECUTE 0x4
+
+typedef enum StopReason {
+    STOP_NONE,
+    STOP_READ,
+    STOP_WRITE,
+    STOP_EXECUTE
+} StopReason;
+
+typedef struct Watchpoint {
+    uint16_t address;
+    uint8_t kinds;
+} Watchpoint;
+
+// Watchpoints cost nothing until one is set. Read and write ones take their page out of the page tables so
+// only accesses to it reach the checks in the handlers, execute ones end decoded blocks in front of them and
+// are checked whenever runCPU looks up a block. A hit makes runCPU return with stopReason set, read and
+// write hits once the instruction doing the access has finished.
+typedef struct Debugger {
+    bool enabled;
+    Watchpoint watchpoints[MAX_WATCHPOINTS];
+    int count;
+    // Kinds watched anywhere in each 256 byte page
+    uint8_t pages[0x100];
+    StopReason stopReason;
+    uint16_t stopAddress;
+    uint8_t stopValue;
+    // The breakpoint that stopped execution is passed over once when it carries on
+    bool resuming;
+    uint16_t resumePC;
+} Debugger;
+
+void initDebugger(Debugger* debugger);
+bool addWatchpoint(GameBoy* gameBoy, const uint16_t address, const uint8_t kinds);
+void removeWatchpoint(GameBoy* gameBoy, const uint16_t address, const uint8_t kinds);
+
+void checkWatchpoint(GameBoy* gameBoy, const uint16_t address, const uint8_t kind, const uint8_t value);
+bool checkBreakpoint(GameBoy* gameBoy);
+void resumeDebugger(Debugger* debugger);
+void printStop(GameBoy* gameBoy);
+
+static inline bool isBreakpoint(const Debugger* debugger, const uint16_t address) {
+    if(!(debugger->pages[address >> 8] & WATCH_EXECUTE))
+        return false;
+    for(int i = 0; i < debugger->count; i++)
+        if((debugger->watchpoints[i].address == address) && (debugger->watchpoints[i].kinds & WATCH_EXECUTE))
+            return true;
+    return false;
+}
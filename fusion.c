@@ -0,0 +1,68 @@
+#include "fusion.h"
+#include <stdio.h>
+#include <string.h>
+#include "gameboy.h"
+#include "block_cache.h"
+
+#define FUSION_OPCODES(...) { __VA_ARGS__ }
+#define FUSION(name, length, opcodes, ...) [FUSION_##name] = FUSION_OPCODES opcodes,
+const uint8_t fusionOpcodes[FUSION_COUNT][FUSION_MAX_LENGTH] = {
+#include "fusions.inc"
+};
+#undef FUSION
+#undef FUSION_OPCODES
+
+#define FUSION(name, length, opcodes, ...) [FUSION_##name] = length,
+const uint8_t fusionLengths[FUSION_COUNT] = {
+#include "fusions.inc"
+};
+#undef FUSION
+
+void initFusion(Fusion* fusion, const bool enabled) {
+    memset(fusion, 0, sizeof(Fusion));
+    fusion->enabled = enabled;
+}
+
+static bool matchesFusion(const Block* block, const int start, const FusionKind kind) {
+    if(start + fusionLengths[kind] > block->length)
+        return false;
+    for(int i = 0; i < fusionLengths[kind]; i++)
+        if(block->instructions[start + i].opcode != fusionOpcodes[kind][i])
+            return false;
+    return true;
+}
+
+// Points the first instruction of every fusable sequence at its fused handler, scanning the block front to back
+void classifyFusions(GameBoy* gameBoy, Block* block) {
+    if(!gameBoy->fusion.enabled)
+        return;
+    for(int i = 0; i < block->length; i++)
+        for(FusionKind kind = FUSION_NONE + 1; kind < FUSION_COUNT; kind++)
+            if(matchesFusion(block, i, kind)) {
+                block->instructions[i].handler = FUSION_HANDLERS + kind;
+                i += fusionLengths[kind] - 1;
+                break;
+            }
+}
+
+// Sequences are counted when entered, one that is left early still counts all of its instructions
+void printFusionStats(Fusion* fusion) {
+    uint64_t executions = 0;
+    uint64_t instructions = 0;
+    for(int kind = FUSION_NONE + 1; kind < FUSION_COUNT; kind++) {
+        executions += fusion->executions[kind];
+        instructions += fusion->executions[kind] * fusionLengths[kind];
+    }
+    printf("Fused %llu sequences covering %llu instructions\n", (unsigned long long) executions, (unsigned long long) instructions);
+    for(int kind = FUSION_NONE + 1; kind < FUSION_COUNT; kind++) {
+        if(fusion->executions[kind] == 0)
+            continue;
+        char mnemonic[96] = { 0 };
+        for(int i = 0; i < fusionLengths[kind]; i++) {
+            if(i > 0)
+                strncat(mnemonic, "; ", sizeof(mnemonic) - strlen(mnemonic) - 1);
+            strncat(mnemonic, instructionMnemonics[fusionOpcodes[kind][i]], sizeof(mnemonic) - strlen(mnemonic) - 1);
+        }
+        printf("%14llu  %s\n", (unsigned long long) fusion->executions[kind], mnemonic);
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct GameBoy GameBoy;
+typedef struct Block Block;
+
+#define FUSION_MAX_LENGTH 4
+// Dispatch table index of the first fused handler, the ones below are the plain opcodes
+#define FUSION_HANDLERS 0x100
+
+typedef enum FusionKind {
+    FUSION_NONE,
+#define FUSION(name, length, opcodes, ...) FUSION_##name,
+#include "fusions.inc"
+#undef FUSION
+    FUSION_COUNT
+} FusionKind;
+
+// Fusion is an interpreter path. Blocks the JIT has translated run its code and never reach the fused
+// handlers, so with the JIT on only the blocks it left to the interpreter are fused. See --no-jit.
+typedef struct Fusion {
+    bool enabled;
+    uint64_t executions[FUSION_COUNT];
+} Fusion;
+
+extern const uint8_t fusionOpcodes[FUSION_COUNT][FUSION_MAX_LENGTH];
+extern const uint8_t fusionLengths[FUSION_COUNT];
+
+void initFusion(Fusion* fusion, const bool enabled);
+
+void classifyFusions(GameBoy* gameBoy, Block* block);
+
+void printFusionStats(Fusion* fusion);
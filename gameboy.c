@@ -1,185 +1,437 @@
 #include "gameboy.h"
+#include <stdlib.h>
 #include <time.h>
+#include <string.h>
+#include <signal.h>
 
 #include <SDL2/SDL.h>
 
 #define VERTICAL_BLANK_SCAN_LINE 144
 #define VERTICAL_BLANK_SCAN_LINE_MAX 153
-#define SCANLINE_COUNTER_START 456
 
 bool gameboyDebug() { return false; }
 
+// Set by SIGUSR1 or P to dump the opcode stats at the end of the frame
+static volatile sig_atomic_t opcodeStatsRequested = 0;
+
+void requestOpcodeStats(int number) { opcodeStatsRequested = 1; }
+
+// Zeroed and rounded up to whole cache lines, aligned_alloc wants the size to be a multiple of the alignment
+static void* allocateAligned(const size_t size) {
+    size_t rounded = (size + MEMORY_ALIGNMENT - 1) & ~(size_t) (MEMORY_ALIGNMENT - 1);
+    void* memory = aligned_alloc(MEMORY_ALIGNMENT, rounded);
+    if(memory != NULL)
+        memset(memory, 0, rounded);
+    return memory;
+}
+
+// The state itself stays small, the memory regions and the framebuffer live in their own buffers
+GameBoy* allocateGameBoy(void) {
+    GameBoy* gameBoy = allocateAligned(sizeof(GameBoy));
+    if(gameBoy == NULL)
+        return NULL;
+    gameBoy->vram = allocateAligned(VRAM_SIZE);
+    gameBoy->wram = allocateAligned(WRAM_SIZE);
+    gameBoy->oam = allocateAligned(OAM_SIZE);
+    gameBoy->ioPorts = allocateAligned(IO_SIZE);
+    gameBoy->hram = allocateAligned(HRAM_SIZE);
+    gameBoy->screenData = allocateAligned(WIDTH * HEIGHT * 3);
+    if(!gameBoy->vram || !gameBoy->wram || !gameBoy->oam || !gameBoy->ioPorts || !gameBoy->hram || !gameBoy->screenData) {
+        freeGameBoy(gameBoy);
+        return NULL;
+    }
+    return gameBoy;
+}
+
+void freeGameBoy(GameBoy* gameBoy) {
+    if(gameBoy == NULL)
+        return;
+    free(gameBoy->vram);
+    free(gameBoy->wram);
+    free(gameBoy->oam);
+    free(gameBoy->ioPorts);
+    free(gameBoy->hram);
+    free(gameBoy->screenData);
+    free(gameBoy);
+}
+
+// The source page is resolved to host memory once and copied in one go. Sources the page tables leave to
+// the handlers, a RAM area the mapper serves itself or 0xfe00 and up, are read a byte at a time.
+// Accurate mode only takes the bus here, dmaEvent moves the bytes as the cycles pass.
 void doDMATransfer(GameBoy* gameBoy, const uint8_t value) {
     uint16_t address = ((uint16_t) value) << 8;
-    for(int i = 0; i < 0xa0; i++)
-        writeToMemory(gameBoy, 0xfe00 + i, readFromMemory(gameBoy, address + i));
-}
-
-void doRAMBankEnable(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
-    if(gameBoy->mBC2)
-        if(bit_value(address, 4) == 1)
-            return;
-    uint8_t testData = (value & 0xf);
-    if(testData == 0xa)
-        gameBoy->enableRAM = true;
-    else if(testData == 0x0)
-        gameBoy->enableRAM = false;
-}
-
-void doChangeLoROMBank(GameBoy* gameBoy, const uint8_t value) {
-    if(gameBoy->mBC2) {
-        gameBoy->currentROMBank = (value & 0xf);
-        if(gameBoy->currentROMBank == 0)
-            gameBoy->currentROMBank++;
+    DMA* dma = &gameBoy->dma;
+    if(dma->accurate) {
+        // A transfer started while another runs replaces it
+        dma->source = address;
+        dma->copied = 0;
+        scheduleEvent(&gameBoy->scheduler, EVENT_DMA, gameBoy->scheduler.cycles + 4);
+        if(!dma->active) {
+            dma->active = true;
+            mapMemory(gameBoy);
+        }
+        // Whatever runs outside HRAM now fetches 0xff
+        gameBoy->blockCache.epoch++;
+        gameBoy->fetchLength = 0;
         return;
     }
-    uint8_t lower5 = value & 31;
-    gameBoy->currentROMBank &= 224;
-    gameBoy->currentROMBank |= lower5;
-    if(gameBoy->currentROMBank == 0)
-        gameBoy->currentROMBank++;
+    const uint8_t* source = gameBoy->readPages[value];
+    if(source != NULL)
+        memcpy(gameBoy->oam, source, OAM_SIZE);
+    else
+        for(int i = 0; i < OAM_SIZE; i++)
+            gameBoy->oam[i] = peekMemory(gameBoy, address + i);
 }
 
-void doChangeHiROMBank(GameBoy* gameBoy, const uint8_t value) {
-    uint8_t newValue = value & 224;
-    gameBoy->currentROMBank &= 31;
-    gameBoy->currentROMBank |= newValue;
-    if(gameBoy->currentROMBank == 0)
-        gameBoy->currentROMBank++;
+// The mapper decides what the write means, the page tables only follow the banks that moved
+void handleBanking(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    // Blocks are keyed by bank, only the one currently running has to be abandoned
+    gameBoy->blockCache.epoch++;
+    gameBoy->fetchLength = 0;
+    const uint8_t* romBankBase = gameBoy->romBankBase;
+    uint8_t* ramBankBase = gameBoy->ramBankBase;
+    bool enableRAM = gameBoy->enableRAM;
+    gameBoy->mapper->writeControl(gameBoy, address, value);
+    // Games disable RAM once they are done saving
+    if(enableRAM && !gameBoy->enableRAM)
+        flushSaveRAM(gameBoy);
+    updateBanks(gameBoy);
+    if(gameBoy->romBankBase != romBankBase)
+        for(int page = 0x40; page < 0x80; page++)
+            mapPage(gameBoy, page);
+    if((gameBoy->ramBankBase != ramBankBase) || (gameBoy->enableRAM != enableRAM))
+        for(int page = 0xa0; page < 0xc0; page++)
+            mapPage(gameBoy, page);
 }
 
-void doRAMBankChange(GameBoy* gameBoy, const uint8_t value) {
-    gameBoy->currentRAMBank = (value & 0x3);
-}
+// Pages that are plain memory point into the buffer behind them, bank 0 straight into the cartridge. Echo RAM pages point at the WRAM they
+// mirror for both reads and writes, so nothing is ever stored twice. WRAM pages holding cached code,
+// and their echoes, are left to the handler so writes to them invalidate the blocks.
+// Clean pages of battery RAM are left to the handler too, until a write there marks them dirty,
+// as are pages with watchpoints for the kind of access they watch.
+void mapPage(GameBoy* gameBoy, const uint8_t page) {
+    uint16_t address = page << 8;
+    if(address < 0x4000)
+        gameBoy->readPages[page] = &gameBoy->cartridge.data[address];
+    else if(address < 0x8000)
+        gameBoy->readPages[page] = &gameBoy->romBankBase[address - 0x4000];
+    else if(address < 0xa000)
+        gameBoy->readPages[page] = &gameBoy->vram[address - 0x8000];
+    else if(address < 0xc000)
+        gameBoy->readPages[page] = (gameBoy->ramBankBase != NULL) ? &gameBoy->ramBankBase[address - 0xa000] : NULL;
+    else if(address < 0xe000)
+        gameBoy->readPages[page] = &gameBoy->wram[address - 0xc000];
+    else if(address < 0xfe00)
+        gameBoy->readPages[page] = &gameBoy->wram[address - 0xe000];
+    else
+        gameBoy->readPages[page] = NULL;
+    if(gameBoy->debugger.pages[page] & WATCH_READ)
+        gameBoy->readPages[page] = NULL;
+    // While an accurate DMA holds the bus, CPU reads below HRAM all go to the handler
+    if(gameBoy->dma.active) {
+        gameBoy->dma.pages[page] = gameBoy->readPages[page];
+        gameBoy->readPages[page] = NULL;
+    }
 
-void doChangeROMRAMMode(GameBoy* gameBoy, const uint8_t value) {
-    uint8_t newValue = value & 0x1;
-    gameBoy->romBanking = (newValue == 0);
-    if(gameBoy->romBanking)
-        gameBoy->currentRAMBank = 0;
+    if((address >= 0x8000) && (address < 0xa000))
+        gameBoy->writePages[page] = &gameBoy->vram[address - 0x8000];
+    else if((address >= 0xa000) && (address < 0xc000) && gameBoy->enableRAM && (gameBoy->ramBankBase != NULL)) {
+        uint8_t* target = &gameBoy->ramBankBase[address - 0xa000];
+        gameBoy->writePages[page] = isSaveRAMWritable(&gameBoy->saveRAM, target) ? target : NULL;
+    } else if((address >= 0xc000) && (address < 0xe000) && !gameBoy->blockCache.codePages[page])
+        gameBoy->writePages[page] = &gameBoy->wram[address - 0xc000];
+    else if((address >= 0xe000) && (address < 0xfe00) && !gameBoy->blockCache.codePages[page - 0x20])
+        gameBoy->writePages[page] = &gameBoy->wram[address - 0xe000];
+    else
+        gameBoy->writePages[page] = NULL;
+    if(gameBoy->debugger.pages[page] & WATCH_WRITE)
+        gameBoy->writePages[page] = NULL;
+
+    // 0xc000-0xddff is mirrored at 0xe000-0xfdff, the echo has to follow whatever backs its WRAM page
+    if((address >= 0xc000) && (address < 0xde00))
+        mapPage(gameBoy, page + 0x20);
 }
 
-void handleBanking(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
-    if(address < 0x2000) {
-        if(gameBoy->mBC1 || gameBoy->mBC2)
-            doRAMBankEnable(gameBoy, address, value);
-    } else if((address >= 0x2000) && (address < 0x4000)) {
-        if(gameBoy->mBC1 || gameBoy->mBC2)
-            doChangeLoROMBank(gameBoy, value);
-    } else if((address >= 0x4000) && (address < 0x6000)) {
-        if(gameBoy->mBC1) {
-            if(gameBoy->romBanking)
-                doChangeHiROMBank(gameBoy, value);
-            else
-                doRAMBankChange(gameBoy, value);
-        }
-    } else if((address >= 0x6000) && (address < 0x8000)) {
-        if(gameBoy->mBC1)
-            doChangeROMRAMMode(gameBoy, value);
-    }
+void mapMemory(GameBoy* gameBoy) {
+    for(int page = 0; page < 0x100; page++)
+        mapPage(gameBoy, page);
 }
 
-uint8_t readFromMemory(GameBoy* gameBoy, const uint16_t address) {
-    if((address >= 0x4000) && (address <= 0x7fff)) {
-        uint16_t newAddress = address - 0x4000;
-        return gameBoy->cartridge[newAddress + (gameBoy->currentROMBank * 0x4000)];
-    } else if((address >= 0xa000) && (address <= 0xbfff)) {
-        uint16_t newAddress = address - 0xa000;
-        return gameBoy->ramBanks[newAddress + (gameBoy->currentRAMBank * 0x2000)];
-    } else if((address >= 0xfea0) && (address < 0xff00)) {
+// Everything the page tables do not map, OAM, the unusable area, IO and HRAM included
+static uint8_t readBus(GameBoy* gameBoy, const uint16_t address) {
+    if(address < 0x4000) {
+        return gameBoy->cartridge.data[address];
+    } else if(address < 0x8000) {
+        return gameBoy->romBankBase[address - 0x4000];
+    } else if(address < 0xa000) {
+        return gameBoy->vram[address - 0x8000];
+    } else if(address < 0xc000) {
+        return gameBoy->mapper->readRAM(gameBoy, address);
+    } else if(address < 0xe000) {
+        return gameBoy->wram[address - 0xc000];
+    } else if(address < 0xfe00) {
+        return gameBoy->wram[address - 0xe000];
+    } else if(address < 0xfea0) {
+        return gameBoy->oam[address - 0xfe00];
+    } else if(address < 0xff00) {
         // TODO OAM Corruption Bug
         return 0xff;
-    } else if(address == 0xff00) {
-        return getGamepadState(gameBoy);
     } else
-        return gameBoy->rom[address];
+        return readIO(gameBoy, address);
+}
+
+uint8_t peekMemoryHandler(GameBoy* gameBoy, const uint16_t address) {
+    if(gameBoy->dma.active && (address < 0xff80))
+        return 0xff;
+    return readBus(gameBoy, address);
+}
+
+uint8_t readFromMemoryHandler(GameBoy* gameBoy, const uint16_t address) {
+    uint8_t value = peekMemoryHandler(gameBoy, address);
+    if(gameBoy->debugger.pages[address >> 8] & WATCH_READ)
+        checkWatchpoint(gameBoy, address, WATCH_READ, value);
+    return value;
+}
+
+// One byte per event, so a CPU write to the source lands in OAM only if its byte has not moved yet
+// and the PPU sees a partly copied OAM while the transfer runs
+void dmaEvent(GameBoy* gameBoy, const uint64_t deadline) {
+    DMA* dma = &gameBoy->dma;
+    uint16_t address = dma->source + dma->copied;
+    const uint8_t* page = dma->pages[address >> 8];
+    gameBoy->oam[dma->copied++] = (page != NULL) ? page[address & 0xff] : readBus(gameBoy, address);
+    if(dma->copied < OAM_SIZE) {
+        scheduleEvent(&gameBoy->scheduler, EVENT_DMA, deadline + 4);
+        return;
+    }
+    dma->active = false;
+    mapMemory(gameBoy);
+}
+
+// Points the fetch region at whichever part of the address space holding address readFromMemory serves
+// straight from one buffer: bank 0, the switched ROM bank, VRAM, the RAM bank, WRAM, echo RAM, OAM or HRAM.
+// The unusable area, the IO registers and a RAM area the mapper serves itself are left to readFromMemory,
+// as is everything below HRAM while an accurate DMA holds the bus.
+bool refreshFetchRegion(GameBoy* gameBoy, const uint16_t address) {
+    if(gameBoy->dma.active && (address < 0xff80)) {
+        gameBoy->fetchLength = 0;
+        return false;
+    } else if(address < 0x4000) {
+        gameBoy->fetchRegion = gameBoy->cartridge.data;
+        gameBoy->fetchStart = 0x0000;
+        gameBoy->fetchLength = 0x4000;
+    } else if(address < 0x8000) {
+        gameBoy->fetchRegion = gameBoy->romBankBase;
+        gameBoy->fetchStart = 0x4000;
+        gameBoy->fetchLength = 0x4000;
+    } else if(address < 0xa000) {
+        gameBoy->fetchRegion = gameBoy->vram;
+        gameBoy->fetchStart = 0x8000;
+        gameBoy->fetchLength = 0x2000;
+    } else if(address < 0xc000) {
+        // An RTC register or MBC2 RAM is left to readFromMemory
+        if(gameBoy->ramBankBase == NULL) {
+            gameBoy->fetchLength = 0;
+            return false;
+        }
+        gameBoy->fetchRegion = gameBoy->ramBankBase;
+        gameBoy->fetchStart = 0xa000;
+        gameBoy->fetchLength = 0x2000;
+    } else if(address < 0xe000) {
+        gameBoy->fetchRegion = gameBoy->wram;
+        gameBoy->fetchStart = 0xc000;
+        gameBoy->fetchLength = 0x2000;
+    } else if(address < 0xfe00) {
+        gameBoy->fetchRegion = gameBoy->wram;
+        gameBoy->fetchStart = 0xe000;
+        gameBoy->fetchLength = 0x1e00;
+    } else if(address < 0xfea0) {
+        gameBoy->fetchRegion = gameBoy->oam;
+        gameBoy->fetchStart = 0xfe00;
+        gameBoy->fetchLength = 0xa0;
+    } else if(address >= 0xff80) {
+        gameBoy->fetchRegion = gameBoy->hram;
+        gameBoy->fetchStart = 0xff80;
+        gameBoy->fetchLength = 0x80;
+    } else {
+        gameBoy->fetchLength = 0;
+        return false;
+    }
+    return true;
 }
 
-void writeToMemory(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+void writeToMemoryHandler(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    if(gameBoy->debugger.pages[address >> 8] & WATCH_WRITE)
+        checkWatchpoint(gameBoy, address, WATCH_WRITE, value);
     if(address < 0x8000) {
         handleBanking(gameBoy, address, value);
-    } else if((address >= 0xa000) && (address < 0xc000)) {
-        if(gameBoy->enableRAM) {
-            uint16_t newAddress = address - 0xa000;
-            gameBoy->ramBanks[newAddress + (gameBoy->currentRAMBank * 0x2000)] = value;
-        }
-    } else if((address >= 0xfea0) && (address < 0xff00)) {
-        // RESTRICTED
-    } else if((address >= 0xc000) && (address < 0xe000)) {
-        gameBoy->rom[address] = value;
-        if(address + 0x2000 <= 0xfdff)
-            gameBoy->rom[address + 0x2000] = value;
-    } else if((address >= 0xe000) && (address < 0xfe00)) {
+    } else if(address < 0xa000) {
+        gameBoy->vram[address - 0x8000] = value;
+    } else if(address < 0xc000) {
+        gameBoy->mapper->writeRAM(gameBoy, address, value);
+        if(gameBoy->saveRAM.battery)
+            mapPage(gameBoy, address >> 8);
+    } else if(address < 0xe000) {
+        invalidateBlocks(gameBoy, address);
+        gameBoy->wram[address - 0xc000] = value;
+    } else if(address < 0xfe00) {
+        // Echo RAM, the write lands in the WRAM it mirrors
+        invalidateBlocks(gameBoy, address - 0x2000);
+        gameBoy->wram[address - 0xe000] = value;
+    } else if(address < 0xfea0) {
+        gameBoy->oam[address - 0xfe00] = value;
+    } else if(address < 0xff00) {
         // RESTRICTED
-        gameBoy->rom[address] = value;
-        gameBoy->rom[address - 0x2000] = value;
-    } else if(address == TAC) {
-        uint8_t currentFreq = getClockFreq(gameBoy);
-        gameBoy->rom[address] = value;
-        uint8_t newFreq = getClockFreq(gameBoy);
-        if(currentFreq != newFreq)
-            setClockFreq(gameBoy);
-    } else if((address == 0xff04) || (address == 0xff44)) {
-        if(address == 0xff04)
-            gameBoy->dividerCounter = 0;
-        gameBoy->rom[address] = 0;
-    } else if(address == 0xff46) {
-        doDMATransfer(gameBoy, value);
     } else
-        gameBoy->rom[address] = value;
+        writeIO(gameBoy, address, value);
 }
 
-void updateTimer(GameBoy* gameBoy, const int cycles) {
-    doDividerRegister(gameBoy, cycles);
-    if(isClockEnabled(gameBoy)) {
-        gameBoy->timerCounter -= cycles;
-        if(gameBoy->timerCounter <= 0) {
-            setClockFreq(gameBoy);
-            if(readFromMemory(gameBoy, TIMA) == 255) {
-                writeToMemory(gameBoy, TIMA, readFromMemory(gameBoy, TMA));
-                requestInterrupt(gameBoy, 2);
-            } else
-                writeToMemory(gameBoy, TIMA, readFromMemory(gameBoy, TIMA) + 1);
-        }
-    }
+// The timer, divider, PPU, DMA and serial port only do something at their events, in between an instruction
+// just moves the cycle count on. Interrupts are still checked every time, EI and writes to IF or IE change
+// what can be serviced from one instruction to the next.
+int updateHardware(GameBoy* gameBoy, const int cycles) {
+    Scheduler* scheduler = &gameBoy->scheduler;
+    scheduler->cycles += cycles;
+    if(scheduler->cycles >= scheduler->nextEvent)
+        runEvents(gameBoy);
+    // The interrupt dispatch is charged to the handler it enters
+    if(gameBoy->profiler.enabled)
+        profileCycles(&gameBoy->profiler, cycles);
+    int interruptCycles = doInterrupts(gameBoy);
+    if(interruptCycles == 0)
+        return cycles;
+    // The handler's first instruction must not see events the dispatch took the count past
+    scheduler->cycles += interruptCycles;
+    if(scheduler->cycles >= scheduler->nextEvent)
+        runEvents(gameBoy);
+    if(gameBoy->profiler.enabled)
+        profileCycles(&gameBoy->profiler, interruptCycles);
+    return cycles + interruptCycles;
 }
 
-bool isClockEnabled(GameBoy* gameBoy) { return bit_value(readFromMemory(gameBoy, TAC), 2) ? true : false; }
+bool isClockEnabled(GameBoy* gameBoy) { return bit_value(gameBoy->ioPorts[TAC - IO_BASE], 2) ? true : false; }
+
+uint8_t getClockFreq(GameBoy* gameBoy) { return gameBoy->ioPorts[TAC - IO_BASE] & 0x3; }
+
+// Cycles per TIMA increment for each TAC frequency, 4096, 262144, 65536 and 16384 Hz
+static const uint64_t timerPeriods[4] = { 1024, 16, 64, 256 };
+
+static uint64_t getTimerPeriod(GameBoy* gameBoy) { return timerPeriods[getClockFreq(gameBoy)]; }
 
-uint8_t getClockFreq(GameBoy* gameBoy) { return readFromMemory(gameBoy, TAC) & 0x3; }
+// The divider bit TIMA counts the falls of, gated by the enable bit
+static bool getTimerSignal(GameBoy* gameBoy) {
+    uint64_t divider = gameBoy->scheduler.cycles - gameBoy->timer.dividerBase;
+    return isClockEnabled(gameBoy) && (divider & (getTimerPeriod(gameBoy) / 2));
+}
+
+static void tickTimer(GameBoy* gameBoy) {
+    if(gameBoy->ioPorts[TIMA - IO_BASE] == 255) {
+        gameBoy->ioPorts[TIMA - IO_BASE] = gameBoy->ioPorts[TMA - IO_BASE];
+        requestInterrupt(gameBoy, 2);
+    } else
+        gameBoy->ioPorts[TIMA - IO_BASE]++;
+}
 
-void setClockFreq(GameBoy* gameBoy) {
-    uint8_t freq = getClockFreq(gameBoy);
-    switch(freq) {
-        case 0: gameBoy->timerCounter = (CYCLES_PER_SECOND / 4096); break ; // freq 4096
-        case 1: gameBoy->timerCounter = (CYCLES_PER_SECOND / 262144); break ;// freq 262144
-        case 2: gameBoy->timerCounter = (CYCLES_PER_SECOND / 65536); break ;// freq 65536
-        case 3: gameBoy->timerCounter = (CYCLES_PER_SECOND / 16382); break ;// freq 16382
+// Adds the increments since timerBase. The overflow is an event, so they never take TIMA past 255.
+static void syncTimer(GameBoy* gameBoy) {
+    Timer* timer = &gameBoy->timer;
+    uint64_t now = gameBoy->scheduler.cycles;
+    if(isClockEnabled(gameBoy)) {
+        uint64_t period = getTimerPeriod(gameBoy);
+        gameBoy->ioPorts[TIMA - IO_BASE] += (now - timer->dividerBase) / period - (timer->timerBase - timer->dividerBase) / period;
     }
+    timer->timerBase = now;
 }
 
-void doDividerRegister(GameBoy* gameBoy, const int cycles) {
-    gameBoy->dividerCounter += cycles;
-    if(gameBoy->dividerCounter >= 255) {
-        gameBoy->dividerCounter = 0;
-        gameBoy->rom[0xff04]++;
+// Increments fall on whole periods of the divider, the overflow is the one taking TIMA past 255
+static void scheduleTimerOverflow(GameBoy* gameBoy) {
+    Timer* timer = &gameBoy->timer;
+    if(!isClockEnabled(gameBoy)) {
+        cancelEvent(&gameBoy->scheduler, EVENT_TIMER);
+        return;
     }
+    uint64_t period = getTimerPeriod(gameBoy);
+    uint64_t increments = (timer->timerBase - timer->dividerBase) / period + (256 - gameBoy->ioPorts[TIMA - IO_BASE]);
+    scheduleEvent(&gameBoy->scheduler, EVENT_TIMER, timer->dividerBase + increments * period);
+}
+
+void timerEvent(GameBoy* gameBoy, const uint64_t deadline) {
+    gameBoy->ioPorts[TIMA - IO_BASE] = gameBoy->ioPorts[TMA - IO_BASE];
+    gameBoy->timer.timerBase = deadline;
+    requestInterrupt(gameBoy, 2);
+    scheduleTimerOverflow(gameBoy);
+}
+
+uint8_t getDivider(GameBoy* gameBoy) { return (gameBoy->scheduler.cycles - gameBoy->timer.dividerBase) >> 8; }
+
+// Resetting the divider while the bit TIMA counts is high is a fall like any other
+void resetDivider(GameBoy* gameBoy) {
+    syncTimer(gameBoy);
+    if(getTimerSignal(gameBoy))
+        tickTimer(gameBoy);
+    gameBoy->timer.dividerBase = gameBoy->scheduler.cycles;
+    scheduleTimerOverflow(gameBoy);
+}
+
+uint8_t getTimerCounter(GameBoy* gameBoy) {
+    syncTimer(gameBoy);
+    return gameBoy->ioPorts[TIMA - IO_BASE];
+}
+
+void setTimerCounter(GameBoy* gameBoy, const uint8_t value) {
+    syncTimer(gameBoy);
+    gameBoy->ioPorts[TIMA - IO_BASE] = value;
+    scheduleTimerOverflow(gameBoy);
+}
+
+// Stopping the timer or switching frequency while the old bit is high makes it fall, as on hardware.
+// TMA is only read when TIMA overflows, writing it needs nothing.
+void setTimerControl(GameBoy* gameBoy, const uint8_t value) {
+    syncTimer(gameBoy);
+    bool signal = getTimerSignal(gameBoy);
+    gameBoy->ioPorts[TAC - IO_BASE] = value;
+    if(signal && !getTimerSignal(gameBoy))
+        tickTimer(gameBoy);
+    scheduleTimerOverflow(gameBoy);
+}
+
+// The next cycle count at which reading DIV or TIMA gives something new
+uint64_t getNextTimerChange(GameBoy* gameBoy) {
+    uint64_t divider = gameBoy->scheduler.cycles - gameBoy->timer.dividerBase;
+    uint64_t period = isClockEnabled(gameBoy) ? getTimerPeriod(gameBoy) : 256;
+    return gameBoy->timer.dividerBase + (divider / period + 1) * period;
 }
 
+// Only a transfer on the internal clock ever finishes, nothing is plugged in to drive the external one
+void setSerialControl(GameBoy* gameBoy, const uint8_t value) {
+    gameBoy->ioPorts[0xff02 - IO_BASE] = value;
+    if((value & 0x81) == 0x81)
+        scheduleEvent(&gameBoy->scheduler, EVENT_SERIAL, gameBoy->scheduler.cycles + SERIAL_CYCLES);
+    else
+        cancelEvent(&gameBoy->scheduler, EVENT_SERIAL);
+}
+
+// With no other Game Boy on the link, the bits shifted in are all 1
+void serialEvent(GameBoy* gameBoy, const uint64_t deadline) {
+    gameBoy->ioPorts[0xff01 - IO_BASE] = 0xff;
+    gameBoy->ioPorts[0xff02 - IO_BASE] = reset_bit(gameBoy->ioPorts[0xff02 - IO_BASE], 7);
+    requestInterrupt(gameBoy, 3);
+}
+
+void updatePendingInterrupts(GameBoy* gameBoy) { gameBoy->pendingInterrupts = gameBoy->ioPorts[0xff0f - IO_BASE] & gameBoy->hram[0xffff - HRAM_BASE]; }
+
 void requestInterrupt(GameBoy* gameBoy, const int interrupt_id) {
-    uint8_t req = readFromMemory(gameBoy, 0xff0f);
-    req = set_bit(req, interrupt_id);
-    writeToMemory(gameBoy, 0xff0f, req);
+    gameBoy->ioPorts[0xff0f - IO_BASE] = set_bit(gameBoy->ioPorts[0xff0f - IO_BASE], interrupt_id);
+    updatePendingInterrupts(gameBoy);
 }
 
 int doInterrupts(GameBoy* gameBoy) {
-    uint8_t req = readFromMemory(gameBoy, 0xff0f);
-    uint8_t enabled = readFromMemory(gameBoy, 0xffff);
-    uint8_t potentialForInterrupts = req & enabled;
-    if(potentialForInterrupts == 0) {
-        if(gameBoy->eiHaltBug) gameBoy->eiHaltBug = false;
+    if(gameBoy->pendingInterrupts == 0) {
+        gameBoy->eiHaltBug = false;
         return 0;
     }
+    uint8_t req = gameBoy->ioPorts[0xff0f - IO_BASE];
+    uint8_t enabled = gameBoy->hram[0xffff - HRAM_BASE];
     if(gameBoy->cpu.interruptsEnabled || gameBoy->eiHaltBug) {
         gameBoy->cpu.halted = false;
         for(int i = 0; i < 5; i++)
@@ -198,11 +450,10 @@ int doInterrupts(GameBoy* gameBoy) {
 
 void serviceInterrupt(GameBoy* gameBoy, const int interrupt_id) {
     gameBoy->cpu.interruptsEnabled = false;
-    uint8_t req = readFromMemory(gameBoy, 0xff0f);
-    req = reset_bit(req, interrupt_id);
-    writeToMemory(gameBoy, 0xff0f, req);
+    gameBoy->ioPorts[0xff0f - IO_BASE] = reset_bit(gameBoy->ioPorts[0xff0f - IO_BASE], interrupt_id);
+    updatePendingInterrupts(gameBoy);
 
-    push(gameBoy, (uint8_t) gameBoy->cpu.pc, (uint8_t) (gameBoy->cpu.pc >> 8));
+    push(gameBoy, gameBoy->cpu.pc);
 
     switch(interrupt_id) {
         case 0: gameBoy->cpu.pc = 0x40; break;
@@ -211,84 +462,79 @@ void serviceInterrupt(GameBoy* gameBoy, const int interrupt_id) {
         case 3: gameBoy->cpu.pc = 0x58; break;
         case 4: gameBoy->cpu.pc = 0x60; break;
     }
+    if(gameBoy->profiler.enabled)
+        profileCall(gameBoy, true);
 }
 
-bool isLCDEnabled(GameBoy* gameBoy) { return bit_value(readFromMemory(gameBoy, 0xff40), 7); }
+bool isLCDEnabled(GameBoy* gameBoy) { return bit_value(gameBoy->ioPorts[0xff40 - IO_BASE], 7); }
+
+// Enters mode, requesting the STAT interrupt when the status register has it enabled for that mode
+static void setLCDMode(GameBoy* gameBoy, const uint8_t mode) {
+    uint8_t status = (gameBoy->ioPorts[0xff41 - IO_BASE] & 252) | mode;
+    gameBoy->ioPorts[0xff41 - IO_BASE] = status;
+    if((mode != 3) && bit_value(status, 3 + mode))
+        requestInterrupt(gameBoy, 1);
+}
 
-void setLCDStatus(GameBoy* gameBoy) {
-    uint8_t status = readFromMemory(gameBoy, 0xff41);
-    if(!isLCDEnabled(gameBoy)) {
-        gameBoy->scanlineCounter = SCANLINE_COUNTER_START;
-        gameBoy->rom[0xff44] = 0;
-        status &= 252;
-        status = set_bit(status, 0);
-        writeToMemory(gameBoy, 0xff41, status);
+// LY matching LYC requests the STAT interrupt when the match begins, not for as long as it lasts
+void compareLY(GameBoy* gameBoy) {
+    if(!isLCDEnabled(gameBoy))
         return;
-    }
+    uint8_t status = gameBoy->ioPorts[0xff41 - IO_BASE];
+    bool coincidence = gameBoy->ioPorts[0xff44 - IO_BASE] == gameBoy->ioPorts[0xff45 - IO_BASE];
+    if(coincidence && !bit_value(status, 2) && bit_value(status, 6))
+        requestInterrupt(gameBoy, 1);
+    gameBoy->ioPorts[0xff41 - IO_BASE] = set_bit_to(status, 2, coincidence);
+}
 
-    uint8_t currentLine = readFromMemory(gameBoy, 0xff44);
-    uint8_t currentMode = (status & 0x3);
+// Visible lines go through modes 2, 3 and 0, line 144 starts the vertical blank
+static void startLine(GameBoy* gameBoy, const uint64_t start) {
+    uint8_t currentLine = gameBoy->ioPorts[0xff44 - IO_BASE];
+    if(currentLine < VERTICAL_BLANK_SCAN_LINE) {
+        setLCDMode(gameBoy, 2);
+        scheduleEvent(&gameBoy->scheduler, EVENT_LCD_MODE, start + OAM_SCAN_CYCLES);
+    } else if(currentLine == VERTICAL_BLANK_SCAN_LINE) {
+        requestInterrupt(gameBoy, 0);
+        setLCDMode(gameBoy, 1);
+    }
+    compareLY(gameBoy);
+    scheduleEvent(&gameBoy->scheduler, EVENT_LINE, start + LINE_CYCLES);
+}
 
-    uint8_t mode = 0;
-    bool reqInt = false;
+void lineEvent(GameBoy* gameBoy, const uint64_t deadline) {
+    gameBoy->ioPorts[0xff44 - IO_BASE]++;
+    if(gameBoy->ioPorts[0xff44 - IO_BASE] > VERTICAL_BLANK_SCAN_LINE_MAX)
+        gameBoy->ioPorts[0xff44 - IO_BASE] = 0;
+    startLine(gameBoy, deadline);
+}
 
-    if(currentLine >= 144) {
-        mode = 1;
-        status = set_bit(status, 0);
-        status = reset_bit(status, 1);
-        reqInt = bit_value(status, 4);
+// The line is drawn as the transfer ends and the horizontal blank begins
+void lcdModeEvent(GameBoy* gameBoy, const uint64_t deadline) {
+    if((gameBoy->ioPorts[0xff41 - IO_BASE] & 0x3) == 2) {
+        setLCDMode(gameBoy, 3);
+        scheduleEvent(&gameBoy->scheduler, EVENT_LCD_MODE, deadline + TRANSFER_CYCLES);
     } else {
-        int mode2bounds = 456 - 80;
-        int mode3bounds = mode2bounds - 172;
-        if(gameBoy->scanlineCounter >= mode2bounds) {
-            mode = 2;
-            status = set_bit(status, 1);
-            status = reset_bit(status, 0);
-            reqInt = bit_value(status, 5);
-        } else if(gameBoy->scanlineCounter >= mode3bounds) {
-            mode = 3;
-            status = set_bit(status, 1);
-            status = set_bit(status, 0);
-        } else {
-            mode = 0;
-            status = reset_bit(status, 1);
-            status = reset_bit(status, 0);
-            reqInt = bit_value(status, 3);
-        }
+        drawScanline(gameBoy);
+        setLCDMode(gameBoy, 0);
     }
-    if(reqInt && (currentMode != mode))
-        requestInterrupt(gameBoy, 1);
-    if(currentLine == readFromMemory(gameBoy, 0xff45)) {
-        status = set_bit(status, 2);
-        if(bit_value(status, 6))
-            requestInterrupt(gameBoy, 1);
-    } else
-        status = reset_bit(status, 2);
-    writeToMemory(gameBoy, 0xff41, status);
 }
 
-void updateGraphics(GameBoy* gameBoy, const int cycles) {
-    setLCDStatus(gameBoy);
-    if(isLCDEnabled(gameBoy))
-        gameBoy->scanlineCounter -= cycles;
-    else
-        return;
+// Turning the LCD on starts line 0 from the top
+void startLCD(GameBoy* gameBoy) {
+    gameBoy->ioPorts[0xff44 - IO_BASE] = 0;
+    startLine(gameBoy, gameBoy->scheduler.cycles);
+}
 
-    if(gameBoy->scanlineCounter <= 0) {
-        gameBoy->rom[0xff44]++;
-        uint8_t currentLine = readFromMemory(gameBoy, 0xff44);
-        gameBoy->scanlineCounter = SCANLINE_COUNTER_START;
-        if(currentLine == VERTICAL_BLANK_SCAN_LINE) {
-            requestInterrupt(gameBoy, 0);
-        } else if(currentLine > VERTICAL_BLANK_SCAN_LINE_MAX) {
-            gameBoy->rom[0xff44] = 0;
-        } else if(currentLine < VERTICAL_BLANK_SCAN_LINE)
-            drawScanline(gameBoy);
-    }
+void stopLCD(GameBoy* gameBoy) {
+    cancelEvent(&gameBoy->scheduler, EVENT_LCD_MODE);
+    cancelEvent(&gameBoy->scheduler, EVENT_LINE);
+    gameBoy->ioPorts[0xff44 - IO_BASE] = 0;
+    gameBoy->ioPorts[0xff41 - IO_BASE] = (gameBoy->ioPorts[0xff41 - IO_BASE] & 252) | 1;
 }
 
+// The PPU is not on the CPU's bus, it reads VRAM, OAM and the palettes straight from their buffers
 void drawScanline(GameBoy* gameBoy) {
-    uint8_t control = readFromMemory(gameBoy, 0xff40);
+    uint8_t control = gameBoy->ioPorts[0xff40 - IO_BASE];
     if(bit_value(control, 0))
         renderTiles(gameBoy);
     if(bit_value(control, 1))
@@ -299,17 +545,17 @@ void renderTiles(GameBoy* gameBoy) {
     uint16_t tileData = 0;
     uint16_t backgroundMemory = 0;
     bool unsig = true;
-    uint8_t lcdControl = readFromMemory(gameBoy, 0xff40);
+    uint8_t lcdControl = gameBoy->ioPorts[0xff40 - IO_BASE];
 
-    uint8_t scrollY = readFromMemory(gameBoy, 0xff42);
-    uint8_t scrollX = readFromMemory(gameBoy, 0xff43);
-    uint8_t windowY = readFromMemory(gameBoy, 0xff4a);
-    uint8_t windowX = readFromMemory(gameBoy, 0xff4b) - 7;
+    uint8_t scrollY = gameBoy->ioPorts[0xff42 - IO_BASE];
+    uint8_t scrollX = gameBoy->ioPorts[0xff43 - IO_BASE];
+    uint8_t windowY = gameBoy->ioPorts[0xff4a - IO_BASE];
+    uint8_t windowX = gameBoy->ioPorts[0xff4b - IO_BASE] - 7;
 
     bool usingWindow = false;
 
     if(bit_value(lcdControl, 5))
-        if(windowY <= readFromMemory(gameBoy, 0xff44))
+        if(windowY <= gameBoy->ioPorts[0xff44 - IO_BASE])
             usingWindow = true;
     if(bit_value(lcdControl, 4))
         tileData = 0x8000;
@@ -333,9 +579,9 @@ void renderTiles(GameBoy* gameBoy) {
     uint8_t yPos = 0;
 
     if(!usingWindow)
-        yPos = scrollY + readFromMemory(gameBoy, 0xff44);
+        yPos = scrollY + gameBoy->ioPorts[0xff44 - IO_BASE];
     else
-        yPos = readFromMemory(gameBoy, 0xff44) - windowY;
+        yPos = gameBoy->ioPorts[0xff44 - IO_BASE] - windowY;
 
     uint16_t tileRow = (((uint8_t) (yPos / 8)) * 32);
     for(uint pixel = 0; pixel < WIDTH; pixel++) {
@@ -347,9 +593,9 @@ void renderTiles(GameBoy* gameBoy) {
         int16_t tileNum;
         uint16_t tileAddress = backgroundMemory + tileRow + tileCol;
         if(unsig)
-            tileNum = readFromMemory(gameBoy, tileAddress);
+            tileNum = gameBoy->vram[tileAddress - 0x8000];
         else
-            tileNum = (int8_t) readFromMemory(gameBoy, tileAddress);
+            tileNum = (int8_t) gameBoy->vram[tileAddress - 0x8000];
         uint16_t tileLocation = tileData;
         if(unsig)
             tileLocation += (tileNum * 16);
@@ -357,8 +603,8 @@ void renderTiles(GameBoy* gameBoy) {
             tileLocation += ((tileNum + 128) * 16); 
         uint8_t line = yPos % 8;
         line *= 2;
-        uint8_t data1 = readFromMemory(gameBoy, tileLocation + line);
-        uint8_t data2 = readFromMemory(gameBoy, tileLocation + line + 1);
+        uint8_t data1 = gameBoy->vram[tileLocation + line - 0x8000];
+        uint8_t data2 = gameBoy->vram[tileLocation + line + 1 - 0x8000];
 
         int colorBit = xPos % 8;
         colorBit -= 7;
@@ -379,7 +625,7 @@ void renderTiles(GameBoy* gameBoy) {
             case DARK_GRAY: red = 0x77; green = 0x77; blue = 0x77; break;
         }
 
-        int finally = readFromMemory(gameBoy, 0xff44);
+        int finally = gameBoy->ioPorts[0xff44 - IO_BASE];
         if((finally < 0) || (finally > 143) || (pixel < 0) || (pixel > 159))
             continue;
 
@@ -393,20 +639,20 @@ void renderTiles(GameBoy* gameBoy) {
 
 void renderSprites(GameBoy* gameBoy) {
     bool use8x16 = false;
-    uint8_t lcdControl = readFromMemory(gameBoy, 0xff40);
+    uint8_t lcdControl = gameBoy->ioPorts[0xff40 - IO_BASE];
     if(bit_value(lcdControl, 2))
         use8x16 = true;
     for(int sprite = 0; sprite < 40; sprite++) {
         uint8_t index = sprite * 4;
-        uint8_t yPos = readFromMemory(gameBoy, 0xfe00 + index) - 16;
-        uint8_t xPos = readFromMemory(gameBoy, 0xfe00 + index + 1) - 8;
-        uint8_t tileLocation = readFromMemory(gameBoy, 0xfe00 + index + 2);
-        uint8_t attributes = readFromMemory(gameBoy, 0xfe00 + index + 3);
+        uint8_t yPos = gameBoy->oam[index] - 16;
+        uint8_t xPos = gameBoy->oam[index + 1] - 8;
+        uint8_t tileLocation = gameBoy->oam[index + 2];
+        uint8_t attributes = gameBoy->oam[index + 3];
 
         bool yFlip = bit_value(attributes, 6);
         bool xFlip = bit_value(attributes, 5);
         bool priority = !bit_value(attributes, 7);
-        int scanline = readFromMemory(gameBoy, 0xff44);
+        int scanline = gameBoy->ioPorts[0xff44 - IO_BASE];
 
         int ySize = use8x16 ? 16 : 8;
 
@@ -419,9 +665,9 @@ void renderSprites(GameBoy* gameBoy) {
             }
 
             line *= 2;
-            uint16_t dataAddress = (0x8000 + (tileLocation * 16)) + line;
-            uint8_t data1 = readFromMemory(gameBoy, dataAddress);
-            uint8_t data2 = readFromMemory(gameBoy, dataAddress + 1);
+            uint16_t dataOffset = (tileLocation * 16) + line;
+            uint8_t data1 = gameBoy->vram[dataOffset];
+            uint8_t data2 = gameBoy->vram[dataOffset + 1];
 
             for(int tilePixel = 7; tilePixel >= 0; tilePixel--) {
                 int colorBit = tilePixel;
@@ -468,7 +714,7 @@ void renderSprites(GameBoy* gameBoy) {
 
 Color getColor(GameBoy* gameBoy, const uint16_t address, const uint8_t colorNum) {
     Color res = WHITE;
-    uint8_t palette = readFromMemory(gameBoy, address);
+    uint8_t palette = gameBoy->ioPorts[address - IO_BASE];
     int hi = 0;
     int lo = 0;
 
@@ -494,7 +740,7 @@ Color getColor(GameBoy* gameBoy, const uint16_t address, const uint8_t colorNum)
 }
 
 uint8_t getGamepadState(GameBoy* gameBoy) {
-    uint8_t res = gameBoy->rom[0xff00];
+    uint8_t res = gameBoy->ioPorts[0xff00 - IO_BASE];
     res ^= 0xff;
 
     if(!bit_value(res, 4)) {
@@ -520,7 +766,7 @@ void keyPressed(GameBoy* gameBoy, const int key) {
 
     bool button = key > 3;
 
-    uint8_t keyReq = gameBoy->rom[0xff00];
+    uint8_t keyReq = gameBoy->ioPorts[0xff00 - IO_BASE];
     bool shouldRequestInterrupt = false;
 
     if(button && !bit_value(keyReq, 5))
@@ -534,60 +780,160 @@ void keyPressed(GameBoy* gameBoy, const int key) {
 
 void keyReleased(GameBoy* gameBoy, const int key) { gameBoy->gamepadState = set_bit(gameBoy->gamepadState, key); }
 
+// bench.c brings its own main and links against everything else here
+#ifndef PGBE_NO_MAIN
 int main(int argc, char *argv[]) {
-    if(argc != 2)
+    // --no-jit runs everything through the interpreter, --jit-check replays every translated instruction through it
+    // --no-fusion runs common instruction sequences one by one instead of through fused handlers, the JIT's
+    // translated blocks never use them so fusion only matters for what the interpreter runs, all of it with --no-jit
+    // --accurate-dma spreads OAM DMA over 640 cycles with the CPU locked out of everything but HRAM
+    // --headless <frames> runs that many frames as fast as possible without a window
+    // --idle-skip / --no-idle-skip override whether idle loops are fast-forwarded, on by default when headless
+    // --trace <file> records every executed instruction, see trace.h for the format
+    // --opcode-stats counts executions and cycles per opcode, dumped at exit, on P or on SIGUSR1
+    // --profile <file> writes the cycles spent in each guest call stack as collapsed stacks for flamegraphs,
+    // --symbols <file> names the frames from an RGBDS .sym file
+    // --break <pc>, --watch-read <address> and --watch-write <address> (in hex) report every hit and carry on
+    bool useJit = true;
+    bool checkJit = false;
+    bool useFusion = true;
+    bool accurateDMA = false;
+    bool headless = false;
+    int headlessFrames = 0;
+    bool idleSkip = false;
+    bool noIdleSkip = false;
+    const char* tracePath = NULL;
+    bool countOpcodes = false;
+    const char* profilePath = NULL;
+    const char* symbolPath = NULL;
+    const char* romPath = NULL;
+    Watchpoint watchpoints[MAX_WATCHPOINTS];
+    int watchpointCount = 0;
+    for(int i = 1; i < argc; i++) {
+        uint8_t watchKind = 0;
+        if(strcmp(argv[i], "--break") == 0)
+            watchKind = WATCH_EXECUTE;
+        else if(strcmp(argv[i], "--watch-read") == 0)
+            watchKind = WATCH_READ;
+        else if(strcmp(argv[i], "--watch-write") == 0)
+            watchKind = WATCH_WRITE;
+        if((watchKind != 0) && (i + 1 < argc)) {
+            if(watchpointCount < MAX_WATCHPOINTS)
+                watchpoints[watchpointCount++] = (Watchpoint) { strtol(argv[++i], NULL, 16), watchKind };
+            continue;
+        }
+        if(strcmp(argv[i], "--no-jit") == 0)
+            useJit = false;
+        else if(strcmp(argv[i], "--jit-check") == 0)
+            checkJit = true;
+        else if(strcmp(argv[i], "--no-fusion") == 0)
+            useFusion = false;
+        else if(strcmp(argv[i], "--accurate-dma") == 0)
+            accurateDMA = true;
+        else if((strcmp(argv[i], "--headless") == 0) && (i + 1 < argc)) {
+            headless = true;
+            headlessFrames = atoi(argv[++i]);
+        } else if(strcmp(argv[i], "--idle-skip") == 0)
+            idleSkip = true;
+        else if(strcmp(argv[i], "--no-idle-skip") == 0)
+            noIdleSkip = true;
+        else if((strcmp(argv[i], "--trace") == 0) && (i + 1 < argc))
+            tracePath = argv[++i];
+        else if(strcmp(argv[i], "--opcode-stats") == 0)
+            countOpcodes = true;
+        else if((strcmp(argv[i], "--profile") == 0) && (i + 1 < argc))
+            profilePath = argv[++i];
+        else if((strcmp(argv[i], "--symbols") == 0) && (i + 1 < argc))
+            symbolPath = argv[++i];
+        else
+            romPath = argv[i];
+    }
+    if(romPath == NULL)
         return 1;
 
-    if(SDL_Init(SDL_INIT_VIDEO) != 0) {
-        fprintf(stderr, "Could not init SDL: %s\n", SDL_GetError());
+    SDL_Window* screen = NULL;
+    SDL_Renderer* renderer = NULL;
+    SDL_Texture* texture = NULL;
+
+    if(!headless) {
+        if(SDL_Init(SDL_INIT_VIDEO) != 0) {
+            fprintf(stderr, "Could not init SDL: %s\n", SDL_GetError());
+            return 1;
+        }
+
+        screen = SDL_CreateWindow("PGBE",
+            SDL_WINDOWPOS_UNDEFINED,
+            SDL_WINDOWPOS_UNDEFINED,
+            WIDTH, HEIGHT,
+            SDL_WINDOW_RESIZABLE
+        );
+
+        if(!screen) {
+            fprintf(stderr, "Could not create window\n");
+            return 1;
+        }
+
+        renderer = SDL_CreateRenderer(screen, -1, SDL_RENDERER_SOFTWARE);
+        if(!renderer) {
+            fprintf(stderr, "Could not create renderer\n");
+            return 1;
+        }
+
+        texture = SDL_CreateTexture(
+            renderer,
+            SDL_PIXELFORMAT_RGB24,
+            SDL_TEXTUREACCESS_STREAMING,
+            WIDTH, HEIGHT
+        );
+    }
+
+    GameBoy* gameBoy = allocateGameBoy();
+    if(gameBoy == NULL) {
+        fprintf(stderr, "Could not allocate Game Boy\n");
         return 1;
     }
 
-    SDL_Window* screen = SDL_CreateWindow("PGBE",
-        SDL_WINDOWPOS_UNDEFINED,
-        SDL_WINDOWPOS_UNDEFINED,
-        WIDTH, HEIGHT,
-        SDL_WINDOW_RESIZABLE
-    );
+    gameBoy->romBanking = true;
+    gameBoy->enableRAM = false;
+    gameBoy->haltBug = false;
+    gameBoy->eiHaltBug = false;
+    gameBoy->gamepadState = 0xff;
+    gameBoy->currentROMBank = 1;
+    gameBoy->currentRAMBank = 0;
+    gameBoy->operands = NULL;
+    gameBoy->fetchRegion = NULL;
+    gameBoy->fetchStart = 0;
+    gameBoy->fetchLength = 0;
+    memset(&gameBoy->dma, 0, sizeof(gameBoy->dma));
+    gameBoy->dma.accurate = accurateDMA;
+
+    if(!initBlockCache(&gameBoy->blockCache)) {
+        fprintf(stderr, "Could not allocate block cache\n");
+        return 1;
+    }
 
-    if(!screen) {
-        fprintf(stderr, "Could not create window\n");
+    if(!initJit(&gameBoy->jit, useJit, checkJit)) {
+        fprintf(stderr, "Could not allocate JIT\n");
         return 1;
     }
 
-    SDL_Renderer* renderer = SDL_CreateRenderer(screen, -1, SDL_RENDERER_SOFTWARE);
-    if(!renderer) {
-        fprintf(stderr, "Could not create renderer\n");
+    initFusion(&gameBoy->fusion, useFusion);
+    initIdleLoop(&gameBoy->idleLoop, !noIdleSkip && (headless || idleSkip));
+
+    if(!initTrace(&gameBoy->trace, tracePath)) {
+        fprintf(stderr, "Could not open trace file %s\n", tracePath);
         return 1;
     }
 
-    SDL_Texture* texture = SDL_CreateTexture(
-        renderer,
-        SDL_PIXELFORMAT_RGB24,
-        SDL_TEXTUREACCESS_STREAMING,
-        WIDTH, HEIGHT
-    );
-
-    GameBoy gameBoy;
-
-    gameBoy.scanlineCounter = SCANLINE_COUNTER_START;
-    gameBoy.timerCounter = 1024;
-    gameBoy.dividerCounter = 0;
-    gameBoy.romBanking = false;
-    gameBoy.enableRAM = false;
-    gameBoy.mBC1 = false;
-    gameBoy.mBC2 = false;
-    gameBoy.haltBug = false;
-    gameBoy.eiHaltBug = false;
-    gameBoy.gamepadState = 0xff;
-    gameBoy.currentROMBank = 1;
-    gameBoy.currentRAMBank = 0;
-    
-    memset(gameBoy.ramBanks, 0, sizeof(gameBoy.ramBanks));
-    memset(gameBoy.cartridge, 0, sizeof(gameBoy.cartridge));
-    memset(gameBoy.rom, 0, sizeof(gameBoy.rom));
-    memset(gameBoy.screenData, 0, sizeof(gameBoy.screenData));
-    memset(gameBoy.scanlineBG, 0, sizeof(gameBoy.scanlineBG));
+    if(!initProfiler(&gameBoy->profiler, profilePath, symbolPath)) {
+        fprintf(stderr, "Could not open profile %s or symbols %s\n", profilePath, symbolPath ? symbolPath : "");
+        return 1;
+    }
+
+    initOpcodeStats(&gameBoy->opcodeStats, countOpcodes);
+    initDebugger(&gameBoy->debugger);
+    if(countOpcodes)
+        signal(SIGUSR1, requestOpcodeStats);
     
     CPU cpu;
 
@@ -606,54 +952,66 @@ int main(int argc, char *argv[]) {
     cpu.h = 0x01;
     cpu.l = 0x4d;
 
-    gameBoy.cpu = cpu;
-
-    gameBoy.rom[0xff05] = 0x00;
-    gameBoy.rom[0xff06] = 0x00;
-    gameBoy.rom[0xff07] = 0x00;
-    gameBoy.rom[0xff10] = 0x80;
-    gameBoy.rom[0xff11] = 0xbf;
-    gameBoy.rom[0xff12] = 0xf3;
-    gameBoy.rom[0xff14] = 0xbf;
-    gameBoy.rom[0xff16] = 0x3f;
-    gameBoy.rom[0xff17] = 0x00;
-    gameBoy.rom[0xff19] = 0xbf;
-    gameBoy.rom[0xff1a] = 0x7f;
-    gameBoy.rom[0xff1b] = 0xff;
-    gameBoy.rom[0xff1c] = 0x9f;
-    gameBoy.rom[0xff1e] = 0xbf;
-    gameBoy.rom[0xff20] = 0xff;
-    gameBoy.rom[0xff21] = 0x00;
-    gameBoy.rom[0xff22] = 0x00;
-    gameBoy.rom[0xff23] = 0xbf;
-    gameBoy.rom[0xff24] = 0x77;
-    gameBoy.rom[0xff25] = 0xf3;
-    gameBoy.rom[0xff26] = 0xf1;
-    gameBoy.rom[0xff40] = 0x91;
-    gameBoy.rom[0xff42] = 0x00;
-    gameBoy.rom[0xff43] = 0x00;
-    gameBoy.rom[0xff45] = 0x00;
-    gameBoy.rom[0xff47] = 0xfc;
-    gameBoy.rom[0xff48] = 0xff;
-    gameBoy.rom[0xff49] = 0xff;
-    gameBoy.rom[0xff4a] = 0x00;
-    gameBoy.rom[0xff4b] = 0x00;
-    gameBoy.rom[0xffff] = 0x00;
-
-    FILE* gameFile = fopen(argv[1], "rb");
-    fread(gameBoy.cartridge, 0x2000000, 1, gameFile);
-    fclose(gameFile);
-
-    memcpy(gameBoy.rom, gameBoy.cartridge, 0x8000);
-
-    switch(gameBoy.cartridge[0x147]) {
-        case 1: gameBoy.mBC1 = true; break;
-        case 2: gameBoy.mBC1 = true; break;
-        case 3: gameBoy.mBC1 = true; break;
-        case 5: gameBoy.mBC2 = true; break;
-        case 6: gameBoy.mBC2 = true; break;
-        default: break;
+    gameBoy->cpu = cpu;
+
+    gameBoy->ioPorts[0xff05 - IO_BASE] = 0x00;
+    gameBoy->ioPorts[0xff06 - IO_BASE] = 0x00;
+    gameBoy->ioPorts[0xff07 - IO_BASE] = 0x00;
+    gameBoy->ioPorts[0xff10 - IO_BASE] = 0x80;
+    gameBoy->ioPorts[0xff11 - IO_BASE] = 0xbf;
+    gameBoy->ioPorts[0xff12 - IO_BASE] = 0xf3;
+    gameBoy->ioPorts[0xff14 - IO_BASE] = 0xbf;
+    gameBoy->ioPorts[0xff16 - IO_BASE] = 0x3f;
+    gameBoy->ioPorts[0xff17 - IO_BASE] = 0x00;
+    gameBoy->ioPorts[0xff19 - IO_BASE] = 0xbf;
+    gameBoy->ioPorts[0xff1a - IO_BASE] = 0x7f;
+    gameBoy->ioPorts[0xff1b - IO_BASE] = 0xff;
+    gameBoy->ioPorts[0xff1c - IO_BASE] = 0x9f;
+    gameBoy->ioPorts[0xff1e - IO_BASE] = 0xbf;
+    gameBoy->ioPorts[0xff20 - IO_BASE] = 0xff;
+    gameBoy->ioPorts[0xff21 - IO_BASE] = 0x00;
+    gameBoy->ioPorts[0xff22 - IO_BASE] = 0x00;
+    gameBoy->ioPorts[0xff23 - IO_BASE] = 0xbf;
+    gameBoy->ioPorts[0xff24 - IO_BASE] = 0x77;
+    gameBoy->ioPorts[0xff25 - IO_BASE] = 0xf3;
+    gameBoy->ioPorts[0xff26 - IO_BASE] = 0xf1;
+    gameBoy->ioPorts[0xff40 - IO_BASE] = 0x91;
+    gameBoy->ioPorts[0xff42 - IO_BASE] = 0x00;
+    gameBoy->ioPorts[0xff43 - IO_BASE] = 0x00;
+    gameBoy->ioPorts[0xff45 - IO_BASE] = 0x00;
+    gameBoy->ioPorts[0xff47 - IO_BASE] = 0xfc;
+    gameBoy->ioPorts[0xff48 - IO_BASE] = 0xff;
+    gameBoy->ioPorts[0xff49 - IO_BASE] = 0xff;
+    gameBoy->ioPorts[0xff4a - IO_BASE] = 0x00;
+    gameBoy->ioPorts[0xff4b - IO_BASE] = 0x00;
+    gameBoy->hram[0xffff - HRAM_BASE] = 0x00;
+
+    if(!loadCartridge(&gameBoy->cartridge, romPath)) {
+        fprintf(stderr, "Could not load %s\n", romPath);
+        return 1;
+    }
+
+    gameBoy->mapper = getMapper(gameBoy->cartridge.data[0x147]);
+    gameBoy->ramBankCount = getRAMBankCount(gameBoy->cartridge.data[0x149]);
+    uint8_t cartridgeType = gameBoy->cartridge.data[0x147];
+    uint32_t saveSize = getSaveSize(cartridgeType, gameBoy->cartridge.data[0x149]);
+    // RAM on a cartridge without an MBC takes writes from the start, one without RAM never does
+    gameBoy->enableRAM = !gameBoy->mapper->gatedRAM && (saveSize > 0);
+    if(!initSaveRAM(&gameBoy->saveRAM, romPath, gameBoy->ramBankCount * RAM_BANK_SIZE, saveSize, hasBattery(cartridgeType))) {
+        fprintf(stderr, "Could not allocate cartridge RAM\n");
+        return 1;
     }
+    memset(&gameBoy->rtc, 0, sizeof(gameBoy->rtc));
+    gameBoy->rtc.present = hasRTC(gameBoy->cartridge.data[0x147]);
+    updateBanks(gameBoy);
+    updatePendingInterrupts(gameBoy);
+    initIO(gameBoy);
+    mapMemory(gameBoy);
+    initScheduler(&gameBoy->scheduler);
+    if(isLCDEnabled(gameBoy))
+        startLCD(gameBoy);
+    for(int i = 0; i < watchpointCount; i++)
+        addWatchpoint(gameBoy, watchpoints[i].address, watchpoints[i].kinds);
 
     // 4.194304 MHz = 4194304 cycles per second
     // 59.727500569606 Hz = 59.727500569606 Frames per second
@@ -669,23 +1027,26 @@ int main(int argc, char *argv[]) {
     int pcToRunTo = 0x0;
 
     if(gameboyDebug()) {
-        printCPU(&gameBoy.cpu);
+        printCPU(&gameBoy->cpu);
+        printInstruction(gameBoy, gameBoy->cpu.pc);
         printf("PRESS ENTER TO CONTINUE or PC to run to\n");
         char test[80];
         fgets(test, sizeof test, stdin);
         if(strlen(test) > 0 && test[0] != '\0') {
             sscanf(test, "%x", &pcToRunTo);
             if(pcToRunTo > 0x0)
-                willRunUntilPC = true;
+                willRunUntilPC = addWatchpoint(gameBoy, pcToRunTo, WATCH_EXECUTE);
         }
     }
     // END TESTING SECTION
 
     bool shouldClose = false;
+    int frames = 0;
+    uint64_t totalCycles = 0;
 
     while(!shouldClose) {
         SDL_Event e;
-        while(SDL_PollEvent(&e) > 0) {
+        while(!headless && (SDL_PollEvent(&e) > 0)) {
             switch(e.type) {
                 case  SDL_QUIT: {
                     shouldClose = true;
@@ -703,9 +1064,10 @@ int main(int argc, char *argv[]) {
                         case SDLK_u: key = 5; break; // A
                         case SDLK_b: key = 7; break; // Select
                         case SDLK_n: key = 6; break; // Start
+                        case SDLK_p: opcodeStatsRequested = gameBoy->opcodeStats.enabled; break;
                     }
                     if(key >= 0)
-                        keyPressed(&gameBoy, key);
+                        keyPressed(gameBoy, key);
                     break;
                 }
                 case SDL_KEYUP: {
@@ -722,7 +1084,7 @@ int main(int argc, char *argv[]) {
                         case SDLK_n: key = 6; break; // Start
                     }
                     if(key != -1)
-                        keyReleased(&gameBoy, key);
+                        keyReleased(gameBoy, key);
                     break;
                 }
             }
@@ -731,42 +1093,59 @@ int main(int argc, char *argv[]) {
         clock_t startTime = clock();
         int cyclesThisFrame = 0;
         while(cyclesThisFrame <= CYCLES_PER_FRAME) {
+            if(!gameboyDebug() || willRunUntilPC) {
+                cyclesThisFrame += runCPU(gameBoy, CYCLES_PER_FRAME - cyclesThisFrame);
+                if(gameBoy->debugger.stopReason == STOP_NONE)
+                    continue;
+                // Stepping picks up again at the PC it was asked to run to
+                if(willRunUntilPC && (gameBoy->debugger.stopReason == STOP_EXECUTE) && (gameBoy->debugger.stopAddress == pcToRunTo)) {
+                    removeWatchpoint(gameBoy, pcToRunTo, WATCH_EXECUTE);
+                    willRunUntilPC = false;
+                } else
+                    printStop(gameBoy);
+                resumeDebugger(&gameBoy->debugger);
+                continue;
+            }
+            cyclesThisFrame += skipHalt(gameBoy, cyclesThisFrame, CYCLES_PER_FRAME);
             int cycles = 4;
-            if(!gameBoy.cpu.halted)
-                cycles = updateCPU(&gameBoy) * 4;
+            if(!gameBoy->cpu.halted)
+                cycles = updateCPU(gameBoy) * 4;
             // START TESTING SECTION
             if(gameboyDebug()) {
-                if(gameBoy.rom[0xff02] == 0x81) {
-                    char c = gameBoy.rom[0xff01];
+                if(gameBoy->ioPorts[0xff02 - IO_BASE] == 0x81) {
+                    char c = gameBoy->ioPorts[0xff01 - IO_BASE];
                     printf("%c", c);
-                    gameBoy.rom[0xff02] = 0x0;
+                    gameBoy->ioPorts[0xff02 - IO_BASE] = 0x0;
                 }
-                if(willRunUntilPC) {
-                    if(gameBoy.cpu.pc == pcToRunTo) {
-                        willRunUntilPC = false;
-                        pcToRunTo = 0x0;
-                    }
-                }
-                if(!willRunUntilPC) {
-                    printCPU(&gameBoy.cpu);
-                    printf("PRESS ENTER TO CONTINUE or PC to run to\n");
-                    char test[80];
-                    fgets(test, sizeof test, stdin);
-                    if(strlen(test) > 0 && test[0] != '\0') {
-                        sscanf(test, "%x", &pcToRunTo);
-                        if(pcToRunTo > 0x0)
-                            willRunUntilPC = true;
-                    }
+                printCPU(&gameBoy->cpu);
+                printInstruction(gameBoy, gameBoy->cpu.pc);
+                printf("PRESS ENTER TO CONTINUE or PC to run to\n");
+                char test[80];
+                fgets(test, sizeof test, stdin);
+                if(strlen(test) > 0 && test[0] != '\0') {
+                    sscanf(test, "%x", &pcToRunTo);
+                    if(pcToRunTo > 0x0)
+                        willRunUntilPC = addWatchpoint(gameBoy, pcToRunTo, WATCH_EXECUTE);
                 }
             }
             // END TESTING SECTION
-            cyclesThisFrame += cycles;
-            updateTimer(&gameBoy, cycles);
-            updateGraphics(&gameBoy, cycles);
-            cyclesThisFrame += doInterrupts(&gameBoy);
+            cyclesThisFrame += updateHardware(gameBoy, cycles);
+        }
+        totalCycles += cyclesThisFrame;
+        tickRTC(gameBoy, cyclesThisFrame);
+        tickSaveRAM(gameBoy, cyclesThisFrame);
+        if(opcodeStatsRequested) {
+            opcodeStatsRequested = 0;
+            printOpcodeStats(&gameBoy->opcodeStats);
         }
 
-        SDL_UpdateTexture(texture, NULL, gameBoy.screenData, WIDTH * sizeof(uint8_t) * 3);
+        if(headless) {
+            if(++frames >= headlessFrames)
+                shouldClose = true;
+            continue;
+        }
+
+        SDL_UpdateTexture(texture, NULL, gameBoy->screenData, WIDTH * sizeof(uint8_t) * 3);
         SDL_RenderClear(renderer);
         SDL_RenderCopy(renderer, texture, NULL, NULL);
         SDL_RenderPresent(renderer);
@@ -778,9 +1157,36 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    SDL_DestroyTexture(texture);
-    SDL_DestroyRenderer(renderer);
-    SDL_DestroyWindow(screen);
-    SDL_Quit();
+    if(gameBoy->jit.differential)
+        printJitStats(&gameBoy->jit);
+    if(gameBoy->idleLoop.enabled)
+        printIdleLoopStats(gameBoy, totalCycles);
+    // With the JIT on the few blocks it leaves to the interpreter would make fusion look unused
+    if(headless && gameBoy->fusion.enabled && !gameBoy->jit.enabled)
+        printFusionStats(&gameBoy->fusion);
+    if(gameBoy->trace.enabled)
+        printTraceStats(&gameBoy->trace);
+    if(gameBoy->opcodeStats.enabled)
+        printOpcodeStats(&gameBoy->opcodeStats);
+    if(gameBoy->profiler.enabled) {
+        if(!writeProfile(&gameBoy->profiler))
+            fprintf(stderr, "Could not write profile %s\n", profilePath);
+        printProfilerStats(&gameBoy->profiler);
+    }
+    freeProfiler(&gameBoy->profiler);
+    freeTrace(&gameBoy->trace);
+    freeJit(&gameBoy->jit);
+    freeBlockCache(&gameBoy->blockCache);
+    freeSaveRAM(&gameBoy->saveRAM);
+    freeCartridge(&gameBoy->cartridge);
+    freeGameBoy(gameBoy);
+
+    if(!headless) {
+        SDL_DestroyTexture(texture);
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(screen);
+        SDL_Quit();
+    }
     return 0;
 }
+#endif
@@ -6,6 +6,19 @@
 
 #include "bit_logic.h"
 #include "cpu.h"
+#include "block_cache.h"
+#include "jit.h"
+#include "idle_loop.h"
+#include "trace.h"
+#include "opcode_stats.h"
+#include "profiler.h"
+#include "fusion.h"
+#include "io.h"
+#include "mapper.h"
+#include "cartridge.h"
+#include "save_ram.h"
+#include "debugger.h"
+#include "scheduler.h"
 
 #define WIDTH 160
 #define HEIGHT 144
@@ -16,6 +29,15 @@
 //#define TIME_BETWEEN_FRAMES_IN_NANOSECONDS 16666666.66 BASED ON 60 FPS
 #define TIME_BETWEEN_FRAMES_IN_NANOSECONDS 16742706.2988
 
+#define IO_BASE 0xff00
+#define HRAM_BASE 0xff80
+#define VRAM_SIZE 0x2000
+#define WRAM_SIZE 0x2000
+#define IO_SIZE 0x80
+#define HRAM_SIZE 0x80
+// Every separately allocated region starts on a cache line
+#define MEMORY_ALIGNMENT 64
+
 #define TIMA 0xff05
 #define TMA 0xff06
 #define TAC 0xff07
@@ -27,55 +49,161 @@ typedef enum Color {
     BLACK
 } Color;
 
+#define OAM_SIZE 0xa0
+
+#define LINE_CYCLES 456
+#define OAM_SCAN_CYCLES 80
+#define TRANSFER_CYCLES 172
+// 8 bits at 8192 Hz
+#define SERIAL_CYCLES 4096
+
+// OAM DMA started by a write to 0xff46. Normally the 160 bytes are copied at once. In accurate mode one
+// moves every 4 cycles, each at its own EVENT_DMA, and until the last has, the CPU reads 0xff from
+// everything below HRAM.
+typedef struct DMA {
+    bool accurate;
+    bool active;
+    uint16_t source;
+    // Bytes moved so far in accurate mode
+    uint8_t copied;
+    // What readPages holds once the transfer lets go of the bus, the transfer reads its source through it
+    const uint8_t* pages[0x100];
+} DMA;
+
+// DIV is the upper byte of a divider counting every cycle since it was last reset, TIMA moves on whenever
+// the divider bit selected by TAC falls. Neither is counted as cycles pass, both are worked out from the
+// cycle count when read and only the TIMA overflow is scheduled.
+typedef struct Timer {
+    // Cycle count at which DIV was last written
+    uint64_t dividerBase;
+    // Cycle count up to which TIMA in ioPorts is brought up to date
+    uint64_t timerBase;
+} Timer;
+
 typedef struct GameBoy {
-    int scanlineCounter;
-    int timerCounter;
-    int dividerCounter;
-    bool romBanking;
-    bool enableRAM;
-    bool mBC1;
-    bool mBC2;
+    // Touched on every instruction, kept together at the front so they share the first cache lines
+    CPU cpu;
+    Scheduler scheduler;
+    // IF & IE, refreshed by updatePendingInterrupts whenever either register changes
+    uint8_t pendingInterrupts;
     bool haltBug;
     bool eiHaltBug;
-    CPU cpu;
+    bool romBanking;
+    bool enableRAM;
     uint8_t gamepadState;
-    uint8_t currentROMBank;
+    const uint8_t* operands;
+    // Host memory behind the region holding PC, fetchByte reads it directly until PC leaves the region
+    // or a banking write empties it
+    const uint8_t* fetchRegion;
+    uint16_t fetchStart;
+    uint16_t fetchLength;
+    // Bank numbers as the mapper registers hold them, updateBanks wraps them to the cartridge
+    uint16_t currentROMBank;
     uint8_t currentRAMBank;
-    uint8_t ramBanks[0x8000];
-    uint8_t cartridge[0x200000];
-    uint8_t rom[0x10000];
-    uint8_t screenData[WIDTH * HEIGHT * 3];
+    uint8_t ramBankCount;
+    // Host memory behind 0x4000 and 0xa000, ramBankBase is NULL while the mapper serves the RAM area itself
+    const uint8_t* romBankBase;
+    uint8_t* ramBankBase;
+    const Mapper* mapper;
+    Timer timer;
+    // The address space outside the cartridge, each region its own aligned buffer from allocateGameBoy.
+    // ioPorts holds 0xff00-0xff7f, hram 0xff80-0xffff with IE as its last byte.
+    uint8_t* vram;
+    uint8_t* wram;
+    uint8_t* oam;
+    uint8_t* ioPorts;
+    uint8_t* hram;
+    uint8_t* screenData;
+    // Host memory behind each 256 byte page, readFromMemory and writeToMemory go straight to it.
+    // NULL where an access has side effects or is not plain memory, those go to the handlers instead.
+    // Rebuilt by mapPage whenever what backs a page changes.
+    const uint8_t* readPages[0x100];
+    uint8_t* writePages[0x100];
+    IORegister io[0x100];
     bool scanlineBG[WIDTH];
+    DMA dma;
+    RTC rtc;
+    SaveRAM saveRAM;
+    Cartridge cartridge;
+    BlockCache blockCache;
+    Jit jit;
+    IdleLoop idleLoop;
+    Fusion fusion;
+    Debugger debugger;
+    Trace trace;
+    OpcodeStats opcodeStats;
+    Profiler profiler;
 } GameBoy;
 
+GameBoy* allocateGameBoy(void);
+void freeGameBoy(GameBoy* gameBoy);
+
 bool gameboyDebug();
+void requestOpcodeStats(int number);
 
 void doDMATransfer(GameBoy* gameBoy, const uint8_t value);
 
-void doRAMBankEnable(GameBoy* gameBoy, const uint16_t address, const uint8_t value);
-void doChangeLoROMBank(GameBoy* gameBoy, const uint8_t value);
-void doChangeHiROMBank(GameBoy* gameBoy, const uint8_t value);
-void doRAMBankChange(GameBoy* gameBoy, const uint8_t value);
-void doChangeROMRAMMode(GameBoy* gameBoy, const uint8_t value);
 void handleBanking(GameBoy* gameBoy, const uint16_t address, const uint8_t value);
 
-uint8_t readFromMemory(GameBoy* gameBoy, const uint16_t address);
-void writeToMemory(GameBoy* gameBoy, const uint16_t address, const uint8_t value);
+void mapPage(GameBoy* gameBoy, const uint8_t page);
+void mapMemory(GameBoy* gameBoy);
+uint8_t readFromMemoryHandler(GameBoy* gameBoy, const uint16_t address);
+uint8_t peekMemoryHandler(GameBoy* gameBoy, const uint16_t address);
+void writeToMemoryHandler(GameBoy* gameBoy, const uint16_t address, const uint8_t value);
+bool refreshFetchRegion(GameBoy* gameBoy, const uint16_t address);
+
+static inline uint8_t readFromMemory(GameBoy* gameBoy, const uint16_t address) {
+    const uint8_t* page = gameBoy->readPages[address >> 8];
+    if(page != NULL)
+        return page[address & 0xff];
+    return readFromMemoryHandler(gameBoy, address);
+}
+
+// What the CPU would read, without counting as a data access. For opcode fetches, DMA and the debugging
+// tools, watchpoints do not see it.
+static inline uint8_t peekMemory(GameBoy* gameBoy, const uint16_t address) {
+    const uint8_t* page = gameBoy->readPages[address >> 8];
+    if(page != NULL)
+        return page[address & 0xff];
+    return peekMemoryHandler(gameBoy, address);
+}
+
+static inline void writeToMemory(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    uint8_t* page = gameBoy->writePages[address >> 8];
+    if(page != NULL)
+        page[address & 0xff] = value;
+    else
+        writeToMemoryHandler(gameBoy, address, value);
+}
+
+int updateHardware(GameBoy* gameBoy, const int cycles);
 
-void updateTimer(GameBoy* gameBoy, const int cycles);
 bool isClockEnabled(GameBoy* gameBoy);
 uint8_t getClockFreq(GameBoy* gameBoy);
-void setClockFreq(GameBoy* gameBoy);
-void doDividerRegister(GameBoy* gameBoy, const int cycles);
-
+uint8_t getDivider(GameBoy* gameBoy);
+void resetDivider(GameBoy* gameBoy);
+uint8_t getTimerCounter(GameBoy* gameBoy);
+void setTimerCounter(GameBoy* gameBoy, const uint8_t value);
+void setTimerControl(GameBoy* gameBoy, const uint8_t value);
+uint64_t getNextTimerChange(GameBoy* gameBoy);
+void setSerialControl(GameBoy* gameBoy, const uint8_t value);
+
+void updatePendingInterrupts(GameBoy* gameBoy);
 void requestInterrupt(GameBoy* gameBoy, const int interrupt_id);
 int doInterrupts(GameBoy* gameBoy);
 void serviceInterrupt(GameBoy* gameBoy, const int interrupt_id);
 
 bool isLCDEnabled(GameBoy* gameBoy);
-void setLCDStatus(GameBoy* gameBoy);
+void startLCD(GameBoy* gameBoy);
+void stopLCD(GameBoy* gameBoy);
+void compareLY(GameBoy* gameBoy);
+
+void lcdModeEvent(GameBoy* gameBoy, const uint64_t deadline);
+void lineEvent(GameBoy* gameBoy, const uint64_t deadline);
+void timerEvent(GameBoy* gameBoy, const uint64_t deadline);
+void dmaEvent(GameBoy* gameBoy, const uint64_t deadline);
+void serialEvent(GameBoy* gameBoy, const uint64_t deadline);
 
-void updateGraphics(GameBoy* gameboy, const int cycles);
 void drawScanline(GameBoy* gameBoy);
 void renderSprites(GameBoy* gameBoy);
 void renderTiles(GameBoy* gameBoy);
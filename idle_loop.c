@@ -0,0 +1,214 @@
+#include "idle_loop.h"
+#include <stdio.h>
+#include "gameboy.h"
+#include "block_cache.h"
+
+#define DIV 0xff04
+#define IF 0xff0f
+#define STAT 0xff41
+#define LY 0xff44
+
+// Hardware registers that change on their own, an iteration only counts when none of them moved.
+// DIV is never stored, reading it is what getQuietCycles guards against.
+static const uint16_t ioRegisters[IDLE_LOOP_REGISTERS] = { TIMA, IF, STAT, LY };
+
+typedef enum LoopRead {
+    READ_NONE,
+    READ_FIXED,
+    READ_INDIRECT,
+    READ_WRITES
+} LoopRead;
+
+// Instructions that may appear in a polling loop, anything writing memory, touching the stack or IME is rejected
+static LoopRead getLoopRead(const DecodedInstruction* decoded, uint16_t* address) {
+    uint8_t opcode = decoded->opcode;
+    if(opcode == 0xcb) {
+        uint8_t cbOpcode = decoded->operands[0];
+        if((cbOpcode & 0x7) != 0x6)
+            return READ_NONE;
+        // Only BIT n, (HL) leaves (HL) alone
+        return ((cbOpcode >= 0x40) && (cbOpcode < 0x80)) ? READ_INDIRECT : READ_WRITES;
+    }
+    if((opcode >= 0x40) && (opcode < 0xc0)) {
+        if((opcode >= 0x70) && (opcode < 0x78))
+            return READ_WRITES;
+        return ((opcode & 0x7) == 0x6) ? READ_INDIRECT : READ_NONE;
+    }
+    switch(opcode) {
+        case 0x00: // NOP
+        case 0x01: case 0x11: case 0x21: case 0x31: // LD rr, u16
+        case 0x03: case 0x13: case 0x23: case 0x33: case 0x0b: case 0x1b: case 0x2b: case 0x3b: // INC rr, DEC rr
+        case 0x04: case 0x0c: case 0x14: case 0x1c: case 0x24: case 0x2c: case 0x3c: // INC r
+        case 0x05: case 0x0d: case 0x15: case 0x1d: case 0x25: case 0x2d: case 0x3d: // DEC r
+        case 0x06: case 0x0e: case 0x16: case 0x1e: case 0x26: case 0x2e: case 0x3e: // LD r, u8
+        case 0x07: case 0x0f: case 0x17: case 0x1f: // RLCA, RRCA, RLA, RRA
+        case 0x09: case 0x19: case 0x29: case 0x39: // ADD HL, rr
+        case 0x27: case 0x2f: case 0x37: case 0x3f: // DAA, CPL, SCF, CCF
+        case 0xc6: case 0xce: case 0xd6: case 0xde: case 0xe6: case 0xee: case 0xf6: case 0xfe: // ALU A, u8
+            return READ_NONE;
+        case 0x0a: case 0x1a: case 0xf2: // LD A, (BC), LD A, (DE), LD A, (C)
+            return READ_INDIRECT;
+        case 0xf0: // LDH A, (u8)
+            *address = 0xff00 + decoded->operands[0];
+            return READ_FIXED;
+        case 0xfa: // LD A, (u16)
+            *address = compose_bytes(decoded->operands[0], decoded->operands[1]);
+            return READ_FIXED;
+        default:
+            return READ_WRITES;
+    }
+}
+
+static bool branchesToStart(const Block* block, const DecodedInstruction* decoded) {
+    switch(decoded->opcode) {
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+            return (uint16_t) (decoded->pc + 2 + (int8_t) decoded->operands[0]) == block->pc;
+        case 0xc2: case 0xc3: case 0xca: case 0xd2: case 0xda: // JP
+            return compose_bytes(decoded->operands[0], decoded->operands[1]) == block->pc;
+        default:
+            return false;
+    }
+}
+
+void initIdleLoop(IdleLoop* idleLoop, const bool enabled) {
+    idleLoop->enabled = enabled;
+    idleLoop->block = NULL;
+    idleLoop->elapsed = 0;
+    idleLoop->skippedCycles = 0;
+    idleLoop->skips = 0;
+    idleLoop->haltedCycles = 0;
+}
+
+void classifyIdleLoop(Block* block) {
+    block->idleLoop = false;
+    block->idleLoopReadsTimer = false;
+    if((block->length == 0) || !branchesToStart(block, &block->instructions[block->length - 1]))
+        return;
+    for(int i = 0; i < block->length - 1; i++) {
+        uint16_t address = 0;
+        switch(getLoopRead(&block->instructions[i], &address)) {
+            case READ_NONE:
+                break;
+            case READ_FIXED:
+                if((address == DIV) || (address == TIMA))
+                    block->idleLoopReadsTimer = true;
+                break;
+            case READ_INDIRECT:
+                block->idleLoopReadsTimer = true;
+                break;
+            case READ_WRITES:
+                return;
+        }
+    }
+    block->idleLoop = true;
+}
+
+// Cycles, at most limit, that can pass without reaching an event, or when the caller reads them,
+// without DIV or TIMA moving on.
+static int getQuietCycles(GameBoy* gameBoy, const int limit, const bool readsTimer) {
+    Scheduler* scheduler = &gameBoy->scheduler;
+    uint64_t next = scheduler->nextEvent;
+    if(readsTimer && (getNextTimerChange(gameBoy) < next))
+        next = getNextTimerChange(gameBoy);
+    if(next <= scheduler->cycles)
+        return 0;
+    return (next - scheduler->cycles - 1 < (uint64_t) limit) ? (int) (next - scheduler->cycles - 1) : limit;
+}
+
+static bool sameState(const CPU* first, const CPU* second) {
+    return (first->a == second->a) && (first->bc == second->bc) && (first->de == second->de) &&
+        (first->hl == second->hl) && (first->sp == second->sp) && (first->pc == second->pc) &&
+        (first->flags == second->flags) && (first->halted == second->halted) &&
+        (first->interruptsEnabled == second->interruptsEnabled) &&
+        (first->pendingInterruptEnable == second->pendingInterruptEnable) &&
+        (first->oneInstructionPassed == second->oneInstructionPassed);
+}
+
+static void saveState(GameBoy* gameBoy, const Block* block, const int elapsed) {
+    IdleLoop* idleLoop = &gameBoy->idleLoop;
+    idleLoop->block = block;
+    idleLoop->cpu = gameBoy->cpu;
+    idleLoop->elapsed = elapsed;
+    for(int i = 0; i < IDLE_LOOP_REGISTERS; i++)
+        idleLoop->io[i] = gameBoy->ioPorts[ioRegisters[i] - IO_BASE];
+}
+
+// Called on every block entry. Once a loop block has gone round once without changing the CPU state or
+// any hardware register, every further iteration is identical until the timer, divider or PPU next does
+// something, so whole iterations up to that point are replaced by moving the cycle count on.
+// Returns the cycles skipped.
+int skipIdleLoop(GameBoy* gameBoy, const Block* block, const int elapsed, const int cycles) {
+    IdleLoop* idleLoop = &gameBoy->idleLoop;
+    if((block == NULL) || !block->idleLoop) {
+        idleLoop->block = NULL;
+        return 0;
+    }
+    bool repeated = (idleLoop->block == block) && sameState(&idleLoop->cpu, &gameBoy->cpu) &&
+        !gameBoy->cpu.pendingInterruptEnable && !gameBoy->haltBug && !gameBoy->eiHaltBug;
+    for(int i = 0; repeated && (i < IDLE_LOOP_REGISTERS); i++)
+        repeated = idleLoop->io[i] == gameBoy->ioPorts[ioRegisters[i] - IO_BASE];
+    if(!repeated) {
+        saveState(gameBoy, block, elapsed);
+        return 0;
+    }
+
+    int iteration = 0;
+    for(int i = 0; i < block->length; i++) {
+        const DecodedInstruction* decoded = &block->instructions[i];
+        iteration += ((i == block->length - 1) ? decoded->branchedCycles : decoded->cycles) * 4;
+    }
+    if((iteration == 0) || (iteration != elapsed - idleLoop->elapsed)) {
+        saveState(gameBoy, block, elapsed);
+        return 0;
+    }
+
+    // Whole iterations that fit before the frame ends and the next event. DIV and TIMA only count when the
+    // loop reads them, nothing else sees them move on.
+    int skipped = (getQuietCycles(gameBoy, cycles - elapsed, block->idleLoopReadsTimer) / iteration) * iteration;
+    if(skipped == 0) {
+        saveState(gameBoy, block, elapsed);
+        return 0;
+    }
+
+    gameBoy->scheduler.cycles += skipped;
+    idleLoop->skippedCycles += skipped;
+    idleLoop->skips++;
+    if(gameBoy->profiler.enabled)
+        profileCycles(&gameBoy->profiler, skipped);
+    saveState(gameBoy, block, elapsed + skipped);
+    return skipped;
+}
+
+// A halted CPU only runs updateHardware 4 cycles at a time. While no interrupt is pending those steps only
+// move the cycle count on, so they are taken in one go up to the step before the next event that could
+// request one, leaving that step to the caller. Returns the cycles skipped.
+int skipHalt(GameBoy* gameBoy, const int elapsed, const int cycles) {
+    if(!gameBoy->cpu.halted || gameBoy->pendingInterrupts)
+        return 0;
+    int skipped = (getQuietCycles(gameBoy, cycles - elapsed, false) / 4) * 4;
+    if(skipped <= 0)
+        return 0;
+    gameBoy->scheduler.cycles += skipped;
+    gameBoy->eiHaltBug = false;
+    gameBoy->idleLoop.haltedCycles += skipped;
+    if(gameBoy->profiler.enabled)
+        profileCycles(&gameBoy->profiler, skipped);
+    return skipped;
+}
+
+void printIdleLoopStats(GameBoy* gameBoy, const uint64_t totalCycles) {
+    char title[17] = { 0 };
+    for(int i = 0; i < 16; i++) {
+        uint8_t c = gameBoy->cartridge.data[0x134 + i];
+        title[i] = ((c >= 0x20) && (c < 0x7f)) ? (char) c : '\0';
+        if(c == 0)
+            break;
+    }
+    IdleLoop* idleLoop = &gameBoy->idleLoop;
+    printf("%s: skipped %llu of %llu cycles (%.1f%%) in %llu idle loop fast-forwards, %llu (%.1f%%) in HALT\n",
+        title[0] ? title : "Untitled",
+        (unsigned long long) idleLoop->skippedCycles, (unsigned long long) totalCycles,
+        totalCycles ? (100.0 * idleLoop->skippedCycles) / totalCycles : 0.0,
+        (unsigned long long) idleLoop->skips, (unsigned long long) idleLoop->haltedCycles,
+        totalCycles ? (100.0 * idleLoop->haltedCycles) / totalCycles : 0.0);
+}
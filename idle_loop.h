@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+
+typedef struct GameBoy GameBoy;
+typedef struct Block Block;
+
+#define IDLE_LOOP_REGISTERS 4
+
+typedef struct IdleLoop {
+    bool enabled;
+    // The loop block entered last, cleared whenever anything else runs in between
+    const Block* block;
+    CPU cpu;
+    uint8_t io[IDLE_LOOP_REGISTERS];
+    int elapsed;
+    uint64_t skippedCycles;
+    uint64_t skips;
+    uint64_t haltedCycles;
+} IdleLoop;
+
+void initIdleLoop(IdleLoop* idleLoop, const bool enabled);
+
+void classifyIdleLoop(Block* block);
+int skipIdleLoop(GameBoy* gameBoy, const Block* block, const int elapsed, const int cycles);
+int skipHalt(GameBoy* gameBoy, const int elapsed, const int cycles);
+
+void printIdleLoopStats(GameBoy* gameBoy, const uint64_t totalCycles);
@@ -0,0 +1,140 @@
+#include "io.h"
+#include "gameboy.h"
+#include "block_cache.h"
+
+#define P1 0xff00
+#define SB 0xff01
+#define SC 0xff02
+#define DIV 0xff04
+#define IF 0xff0f
+#define NR52 0xff26
+#define LCDC 0xff40
+#define STAT 0xff41
+#define LY 0xff44
+#define LYC 0xff45
+#define DMA 0xff46
+#define WX 0xff4b
+#define IE 0xffff
+
+// Bits of the sound registers from NR10 up to the end of wave RAM that always read back as 1.
+// Nothing plays them yet, they are kept in ioPorts so a game reads back what it wrote.
+static const uint8_t soundUnusedBits[0x30] = {
+    0x80, 0x3f, 0x00, 0xff, 0xbf, 0xff, 0x3f, 0x00, 0xff, 0xbf, 0x7f, 0xff, 0x9f, 0xff, 0xbf, 0xff,
+    0xff, 0x00, 0x00, 0xbf, 0x00, 0x00, 0x70, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+// Where the register at address is stored, IO ports and HRAM are separate buffers
+static inline uint8_t* getRegister(GameBoy* gameBoy, const uint16_t address) {
+    return (address < HRAM_BASE) ? &gameBoy->ioPorts[address - IO_BASE] : &gameBoy->hram[address - HRAM_BASE];
+}
+
+static uint8_t readJoypad(GameBoy* gameBoy, const uint16_t address) { return getGamepadState(gameBoy); }
+
+static void writeSerialControl(GameBoy* gameBoy, const uint16_t address, const uint8_t value) { setSerialControl(gameBoy, value); }
+
+static uint8_t readDivider(GameBoy* gameBoy, const uint16_t address) { return getDivider(gameBoy); }
+
+static void writeDivider(GameBoy* gameBoy, const uint16_t address, const uint8_t value) { resetDivider(gameBoy); }
+
+static uint8_t readTimerCounter(GameBoy* gameBoy, const uint16_t address) { return getTimerCounter(gameBoy); }
+
+static void writeTimerCounter(GameBoy* gameBoy, const uint16_t address, const uint8_t value) { setTimerCounter(gameBoy, value); }
+
+static void writeTimerControl(GameBoy* gameBoy, const uint16_t address, const uint8_t value) { setTimerControl(gameBoy, value); }
+
+static void writeInterrupts(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    if(address == IE)
+        invalidateBlocks(gameBoy, address);
+    *getRegister(gameBoy, address) = value;
+    updatePendingInterrupts(gameBoy);
+}
+
+static void writeLCDControl(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    bool wasEnabled = isLCDEnabled(gameBoy);
+    gameBoy->ioPorts[address - IO_BASE] = value;
+    if(isLCDEnabled(gameBoy) && !wasEnabled)
+        startLCD(gameBoy);
+    else if(!isLCDEnabled(gameBoy) && wasEnabled)
+        stopLCD(gameBoy);
+}
+
+static void writeScanline(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    gameBoy->ioPorts[address - IO_BASE] = 0;
+    compareLY(gameBoy);
+}
+
+static void writeScanlineCompare(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    gameBoy->ioPorts[address - IO_BASE] = value;
+    compareLY(gameBoy);
+}
+
+static void writeDMA(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    gameBoy->ioPorts[address - IO_BASE] = value;
+    doDMATransfer(gameBoy, value);
+}
+
+// HRAM can hold cached code
+static void writeHighRAM(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    invalidateBlocks(gameBoy, address);
+    gameBoy->hram[address - HRAM_BASE] = value;
+}
+
+void setIORegister(GameBoy* gameBoy, const uint16_t address, const uint8_t readMask, const uint8_t writeMask,
+    IOReadHandler read, IOWriteHandler write) {
+    IORegister* io = &gameBoy->io[address & 0xff];
+    io->readMask = readMask;
+    io->writeMask = writeMask;
+    io->read = read;
+    io->write = write;
+}
+
+// Addresses nothing answers to read 0xff and ignore writes
+void initIO(GameBoy* gameBoy) {
+    for(int address = 0xff00; address <= 0xffff; address++)
+        setIORegister(gameBoy, address, 0x00, 0x00, NULL, NULL);
+
+    setIORegister(gameBoy, P1, 0x3f, 0x30, readJoypad, NULL);
+    setIORegister(gameBoy, SB, 0xff, 0xff, NULL, NULL);
+    setIORegister(gameBoy, SC, 0x81, 0x81, NULL, writeSerialControl);
+
+    setIORegister(gameBoy, DIV, 0xff, 0xff, readDivider, writeDivider);
+    setIORegister(gameBoy, TIMA, 0xff, 0xff, readTimerCounter, writeTimerCounter);
+    setIORegister(gameBoy, TMA, 0xff, 0xff, NULL, NULL);
+    setIORegister(gameBoy, TAC, 0x07, 0x07, NULL, writeTimerControl);
+    setIORegister(gameBoy, IF, 0x1f, 0x1f, NULL, writeInterrupts);
+
+    for(int i = 0; i < 0x30; i++)
+        setIORegister(gameBoy, 0xff10 + i, ~soundUnusedBits[i], 0xff, NULL, NULL);
+    // Only the power bit of NR52 is writable, the channel status bits stay clear until there is sound
+    setIORegister(gameBoy, NR52, 0x8f, 0x80, NULL, NULL);
+
+    for(int address = LCDC; address <= WX; address++)
+        setIORegister(gameBoy, address, 0xff, 0xff, NULL, NULL);
+    setIORegister(gameBoy, LCDC, 0xff, 0xff, NULL, writeLCDControl);
+    // The mode and coincidence bits belong to the LCD
+    setIORegister(gameBoy, STAT, 0x7f, 0x78, NULL, NULL);
+    setIORegister(gameBoy, LY, 0xff, 0xff, NULL, writeScanline);
+    setIORegister(gameBoy, LYC, 0xff, 0xff, NULL, writeScanlineCompare);
+    setIORegister(gameBoy, DMA, 0xff, 0xff, NULL, writeDMA);
+
+    for(int address = 0xff80; address < IE; address++)
+        setIORegister(gameBoy, address, 0xff, 0xff, NULL, writeHighRAM);
+    setIORegister(gameBoy, IE, 0xff, 0xff, NULL, writeInterrupts);
+}
+
+uint8_t readIO(GameBoy* gameBoy, const uint16_t address) {
+    const IORegister* io = &gameBoy->io[address & 0xff];
+    uint8_t value = (io->read != NULL) ? io->read(gameBoy, address) : *getRegister(gameBoy, address);
+    return value | ~io->readMask;
+}
+
+void writeIO(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    const IORegister* io = &gameBoy->io[address & 0xff];
+    uint8_t* target = getRegister(gameBoy, address);
+    uint8_t merged = (*target & ~io->writeMask) | (value & io->writeMask);
+    if(io->write != NULL)
+        io->write(gameBoy, address, merged);
+    else
+        *target = merged;
+}
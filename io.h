@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct GameBoy GameBoy;
+
+// A read handler returns the raw register value, the read mask is applied on top of it
+typedef uint8_t (*IOReadHandler)(GameBoy* gameBoy, const uint16_t address);
+// A write handler gets the value already merged through the write mask and stores it itself
+typedef void (*IOWriteHandler)(GameBoy* gameBoy, const uint16_t address, const uint8_t value);
+
+// One descriptor per address from 0xff00 to 0xffff. Bits outside the read mask read back as 1,
+// bits outside the write mask keep their value. Without handlers the register is plain memory in ioPorts or hram.
+// Registers whose value is computed on demand install a read handler.
+typedef struct IORegister {
+    uint8_t readMask;
+    uint8_t writeMask;
+    IOReadHandler read;
+    IOWriteHandler write;
+} IORegister;
+
+void initIO(GameBoy* gameBoy);
+void setIORegister(GameBoy* gameBoy, const uint16_t address, const uint8_t readMask, const uint8_t writeMask,
+    IOReadHandler read, IOWriteHandler write);
+
+uint8_t readIO(GameBoy* gameBoy, const uint16_t address);
+void writeIO(GameBoy* gameBoy, const uint16_t address, const uint8_t value);
@@ -0,0 +1,439 @@
+#include "jit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gameboy.h"
+#include "block_cache.h"
+
+#if defined(__x86_64__)
+#include <sys/mman.h>
+
+struct JitSnapshot {
+    CPU cpu;
+    Scheduler scheduler;
+    Timer timer;
+    // pages is rebuilt by mapMemory on restore
+    DMA dma;
+    bool romBanking;
+    bool enableRAM;
+    bool haltBug;
+    bool eiHaltBug;
+    uint16_t currentROMBank;
+    uint8_t currentRAMBank;
+    RTC rtc;
+    uint8_t ramBanks[MAX_RAM_BANKS * RAM_BANK_SIZE];
+    // The regions below, one after the other
+    uint8_t memory[VRAM_SIZE + WRAM_SIZE + OAM_SIZE + IO_SIZE + HRAM_SIZE];
+};
+
+// Each of the GameBoy's memory buffers and the address it starts at
+typedef struct SnapshotRegion {
+    size_t field;
+    uint16_t address;
+    uint16_t size;
+} SnapshotRegion;
+
+static const SnapshotRegion snapshotRegions[5] = {
+    { offsetof(GameBoy, vram), 0x8000, VRAM_SIZE },
+    { offsetof(GameBoy, wram), 0xc000, WRAM_SIZE },
+    { offsetof(GameBoy, oam), 0xfe00, OAM_SIZE },
+    { offsetof(GameBoy, ioPorts), IO_BASE, IO_SIZE },
+    { offsetof(GameBoy, hram), HRAM_BASE, HRAM_SIZE }
+};
+
+static uint8_t* getRegion(GameBoy* gameBoy, const SnapshotRegion* region) {
+    return *(uint8_t**) ((uint8_t*) gameBoy + region->field);
+}
+
+typedef struct Emitter {
+    uint8_t* p;
+    uint8_t* end;
+    bool overflow;
+} Emitter;
+
+#define CPU_OFFSET(field) ((int32_t) (offsetof(GameBoy, cpu) + offsetof(CPU, field)))
+
+// Register operand encoding used by the SM83 opcodes, 6 is (HL) and never translated inline
+static const int32_t registerOffsets[8] = {
+    CPU_OFFSET(b), CPU_OFFSET(c), CPU_OFFSET(d), CPU_OFFSET(e),
+    CPU_OFFSET(h), CPU_OFFSET(l), -1, CPU_OFFSET(a)
+};
+
+// Register pairs as encoded in bits 4-5 of the 16 bit opcodes
+static const int32_t pairOffsets[4] = { CPU_OFFSET(bc), CPU_OFFSET(de), CPU_OFFSET(hl), CPU_OFFSET(sp) };
+
+// Only the banks the cartridge has are copied, MBC2 keeps its 512 half bytes in the first one
+static size_t getRAMSize(GameBoy* gameBoy) { return gameBoy->ramBankCount * RAM_BANK_SIZE; }
+
+static void saveSnapshot(GameBoy* gameBoy, JitSnapshot* snapshot) {
+    snapshot->cpu = gameBoy->cpu;
+    snapshot->scheduler = gameBoy->scheduler;
+    snapshot->timer = gameBoy->timer;
+    snapshot->dma = gameBoy->dma;
+    snapshot->romBanking = gameBoy->romBanking;
+    snapshot->enableRAM = gameBoy->enableRAM;
+    snapshot->haltBug = gameBoy->haltBug;
+    snapshot->eiHaltBug = gameBoy->eiHaltBug;
+    snapshot->currentROMBank = gameBoy->currentROMBank;
+    snapshot->currentRAMBank = gameBoy->currentRAMBank;
+    snapshot->rtc = gameBoy->rtc;
+    memcpy(snapshot->ramBanks, gameBoy->saveRAM.data, getRAMSize(gameBoy));
+    uint8_t* memory = snapshot->memory;
+    for(int i = 0; i < 5; i++) {
+        memcpy(memory, getRegion(gameBoy, &snapshotRegions[i]), snapshotRegions[i].size);
+        memory += snapshotRegions[i].size;
+    }
+}
+
+static void restoreSnapshot(GameBoy* gameBoy, const JitSnapshot* snapshot) {
+    gameBoy->cpu = snapshot->cpu;
+    gameBoy->scheduler = snapshot->scheduler;
+    gameBoy->timer = snapshot->timer;
+    gameBoy->dma = snapshot->dma;
+    gameBoy->romBanking = snapshot->romBanking;
+    gameBoy->enableRAM = snapshot->enableRAM;
+    gameBoy->haltBug = snapshot->haltBug;
+    gameBoy->eiHaltBug = snapshot->eiHaltBug;
+    gameBoy->currentROMBank = snapshot->currentROMBank;
+    gameBoy->fetchLength = 0;
+    gameBoy->currentRAMBank = snapshot->currentRAMBank;
+    gameBoy->rtc = snapshot->rtc;
+    memcpy(gameBoy->saveRAM.data, snapshot->ramBanks, getRAMSize(gameBoy));
+    const uint8_t* memory = snapshot->memory;
+    for(int i = 0; i < 5; i++) {
+        memcpy(getRegion(gameBoy, &snapshotRegions[i]), memory, snapshotRegions[i].size);
+        memory += snapshotRegions[i].size;
+    }
+    updateBanks(gameBoy);
+    updatePendingInterrupts(gameBoy);
+    mapMemory(gameBoy);
+}
+
+static bool sameCPU(CPU* expected, CPU* actual) {
+    return (expected->a == actual->a) && (expected->b == actual->b) && (expected->c == actual->c) &&
+        (expected->d == actual->d) && (expected->e == actual->e) && (expected->h == actual->h) &&
+        (expected->l == actual->l) && (expected->sp == actual->sp) && (expected->pc == actual->pc) &&
+        (getFFlagsAsByte(expected) == getFFlagsAsByte(actual)) &&
+        (expected->halted == actual->halted) &&
+        (expected->interruptsEnabled == actual->interruptsEnabled) &&
+        (expected->pendingInterruptEnable == actual->pendingInterruptEnable) &&
+        (expected->oneInstructionPassed == actual->oneInstructionPassed);
+}
+
+static void reportMismatch(JitSnapshot* expected, JitSnapshot* actual, const uint16_t pc, const uint8_t instruction) {
+    printf("JIT mismatch at %04x (opcode %02x)\n", pc, instruction);
+    if(!sameCPU(&expected->cpu, &actual->cpu)) {
+        printf("  expected:\n");
+        printCPU(&expected->cpu);
+        printf("  actual:\n");
+        printCPU(&actual->cpu);
+    }
+    size_t offset = 0;
+    for(int i = 0; i < 5; i++) {
+        const SnapshotRegion* region = &snapshotRegions[i];
+        for(int j = 0; j < region->size; j++, offset++)
+            if(expected->memory[offset] != actual->memory[offset]) {
+                printf("  memory %04x: expected %02x actual %02x\n", region->address + j,
+                    expected->memory[offset], actual->memory[offset]);
+                return;
+            }
+    }
+}
+
+static void jitBeginCheck(GameBoy* gameBoy) { saveSnapshot(gameBoy, gameBoy->jit.before); }
+
+// Replays the instruction the translated code just executed through decodeAndExecute and keeps the interpreter's result.
+// The profiler, opcode stats and trace are not in the snapshot and already saw the translated pass, so they
+// are switched off for the replay rather than counting the instruction twice.
+static int jitEndCheck(GameBoy* gameBoy, const int timing) {
+    Jit* jit = &gameBoy->jit;
+    saveSnapshot(gameBoy, jit->after);
+    restoreSnapshot(gameBoy, jit->before);
+    gameBoy->operands = NULL;
+    uint16_t pc = gameBoy->cpu.pc;
+    uint8_t instruction = peekMemory(gameBoy, gameBoy->cpu.pc++);
+    bool profiling = gameBoy->profiler.enabled;
+    bool countingOpcodes = gameBoy->opcodeStats.enabled;
+    bool tracing = gameBoy->trace.enabled;
+    gameBoy->profiler.enabled = false;
+    gameBoy->opcodeStats.enabled = false;
+    gameBoy->trace.enabled = false;
+    int expected = decodeAndExecute(gameBoy, instruction);
+    gameBoy->profiler.enabled = profiling;
+    gameBoy->opcodeStats.enabled = countingOpcodes;
+    gameBoy->trace.enabled = tracing;
+    saveSnapshot(gameBoy, jit->before);
+    jit->checkedInstructions++;
+    if((expected != timing) || !sameCPU(&jit->before->cpu, &jit->after->cpu) ||
+        (jit->before->currentROMBank != jit->after->currentROMBank) ||
+        (jit->before->currentRAMBank != jit->after->currentRAMBank) ||
+        (jit->before->dma.active != jit->after->dma.active) || (jit->before->dma.source != jit->after->dma.source) ||
+        (jit->before->dma.copied != jit->after->dma.copied) ||
+        (memcmp(jit->before->memory, jit->after->memory, sizeof(jit->before->memory)) != 0) ||
+        (memcmp(jit->before->ramBanks, jit->after->ramBanks, getRAMSize(gameBoy)) != 0)) {
+        jit->mismatches++;
+        reportMismatch(jit->before, jit->after, pc, instruction);
+    }
+    return expected;
+}
+
+static bool jitFinish(GameBoy* gameBoy, JitContext* context, const int timing, const uint32_t nextPC) {
+    context->elapsed += updateHardware(gameBoy, finishInstruction(gameBoy, timing) * 4);
+    return !gameBoy->cpu.halted && (context->elapsed <= context->cycles) &&
+        (gameBoy->cpu.pc == nextPC) && (context->epoch == gameBoy->blockCache.epoch);
+}
+
+static void emit8(Emitter* emitter, const uint8_t value) {
+    if(emitter->p < emitter->end)
+        *emitter->p++ = value;
+    else
+        emitter->overflow = true;
+}
+
+static void emit16(Emitter* emitter, const uint16_t value) {
+    emit8(emitter, (uint8_t) value);
+    emit8(emitter, (uint8_t) (value >> 8));
+}
+
+static void emit32(Emitter* emitter, const uint32_t value) {
+    emit16(emitter, (uint16_t) value);
+    emit16(emitter, (uint16_t) (value >> 16));
+}
+
+static void emit64(Emitter* emitter, const uint64_t value) {
+    emit32(emitter, (uint32_t) value);
+    emit32(emitter, (uint32_t) (value >> 32));
+}
+
+// mov rax, function; call rax
+static void emitCall(Emitter* emitter, const void* function) {
+    emit8(emitter, 0x48); emit8(emitter, 0xb8); emit64(emitter, (uint64_t) (uintptr_t) function);
+    emit8(emitter, 0xff); emit8(emitter, 0xd0);
+}
+
+// mov rdi, rbx
+static void emitGameBoyArgument(Emitter* emitter) { emit8(emitter, 0x48); emit8(emitter, 0x89); emit8(emitter, 0xdf); }
+
+// add word [rbx + pc], length
+static void emitAdvancePC(Emitter* emitter, const uint8_t length) {
+    emit8(emitter, 0x66); emit8(emitter, 0x83); emit8(emitter, 0x83); emit32(emitter, CPU_OFFSET(pc)); emit8(emitter, length);
+}
+
+// movzx eax, byte [rbx + from]; mov byte [rbx + to], al
+static void emitCopyRegister(Emitter* emitter, const int32_t to, const int32_t from) {
+    emit8(emitter, 0x0f); emit8(emitter, 0xb6); emit8(emitter, 0x83); emit32(emitter, from);
+    emit8(emitter, 0x88); emit8(emitter, 0x83); emit32(emitter, to);
+}
+
+// mov byte [rbx + to], value
+static void emitStoreByte(Emitter* emitter, const int32_t to, const uint8_t value) {
+    emit8(emitter, 0xc6); emit8(emitter, 0x83); emit32(emitter, to); emit8(emitter, value);
+}
+
+
+// Register only instructions without flags are translated to native code, everything else calls its opcode handler
+static bool emitInline(Emitter* emitter, const DecodedInstruction* decoded) {
+    uint8_t opcode = decoded->opcode;
+    if(opcode == 0x00) {
+        // NOP
+    } else if((opcode >= 0x40) && (opcode < 0x80) && (opcode != 0x76)) {
+        // LD r, r
+        int32_t to = registerOffsets[(opcode >> 3) & 0x7];
+        int32_t from = registerOffsets[opcode & 0x7];
+        if((to < 0) || (from < 0))
+            return false;
+        emitCopyRegister(emitter, to, from);
+    } else if((opcode < 0x40) && ((opcode & 0x7) == 0x6)) {
+        // LD r, u8
+        int32_t to = registerOffsets[(opcode >> 3) & 0x7];
+        if(to < 0)
+            return false;
+        emitStoreByte(emitter, to, decoded->operands[0]);
+    } else if((opcode < 0x40) && ((opcode & 0xf) == 0x1)) {
+        // LD rr, u16 as mov word [rbx + rr], u16
+        emit8(emitter, 0x66); emit8(emitter, 0xc7); emit8(emitter, 0x83); emit32(emitter, pairOffsets[opcode >> 4]);
+        emit16(emitter, compose_bytes(decoded->operands[0], decoded->operands[1]));
+    } else if((opcode < 0x40) && (((opcode & 0xf) == 0x3) || ((opcode & 0xf) == 0xb))) {
+        // INC rr, DEC rr as inc word [rbx + rr] or dec word [rbx + rr]
+        bool increment = (opcode & 0xf) == 0x3;
+        emit8(emitter, 0x66); emit8(emitter, 0xff); emit8(emitter, increment ? 0x83 : 0x8b); emit32(emitter, pairOffsets[opcode >> 4]);
+    } else
+        return false;
+    emitAdvancePC(emitter, instructionLengths[opcode]);
+    // mov edx, cycles
+    emit8(emitter, 0xba); emit32(emitter, instructionTimings[opcode]);
+    return true;
+}
+
+static void emitHandlerCall(Emitter* emitter, const DecodedInstruction* decoded, const uint8_t* operands) {
+    // mov rax, operands; mov [rbx + operands], rax
+    emit8(emitter, 0x48); emit8(emitter, 0xb8); emit64(emitter, (uint64_t) (uintptr_t) operands);
+    emit8(emitter, 0x48); emit8(emitter, 0x89); emit8(emitter, 0x83); emit32(emitter, (int32_t) offsetof(GameBoy, operands));
+    emitAdvancePC(emitter, 1);
+    emitGameBoyArgument(emitter);
+    // mov esi, opcode
+    emit8(emitter, 0xbe); emit32(emitter, decoded->opcode);
+    emitCall(emitter, opcodeHandlers[decoded->opcode]);
+    // mov edx, eax
+    emit8(emitter, 0x89); emit8(emitter, 0xc2);
+}
+
+static JitBlockFunction compileBlock(GameBoy* gameBoy, Block* block) {
+    Jit* jit = &gameBoy->jit;
+    uint8_t* start = jit->code + jit->codeUsed;
+    uint8_t* end = jit->code + JIT_CODE_SIZE;
+    if((size_t) (end - start) < (BLOCK_MAX_INSTRUCTIONS * 2) + 16)
+        return NULL;
+
+    // Operand bytes live in front of the code so the handlers can keep reading them through gameBoy->operands
+    uint8_t* operands = start;
+    for(int i = 0; i < block->length; i++) {
+        operands[i * 2] = block->instructions[i].operands[0];
+        operands[(i * 2) + 1] = block->instructions[i].operands[1];
+    }
+    uint8_t* entry = start + (((block->length * 2) + 15) & ~15);
+
+    Emitter emitter = { entry, end, false };
+    Emitter exitJumps[BLOCK_MAX_INSTRUCTIONS];
+    int exitJumpCount = 0;
+
+    // push rbx; push r12; push r13; mov rbx, rdi; mov r12, rsi
+    emit8(&emitter, 0x53);
+    emit8(&emitter, 0x41); emit8(&emitter, 0x54);
+    emit8(&emitter, 0x41); emit8(&emitter, 0x55);
+    emit8(&emitter, 0x48); emit8(&emitter, 0x89); emit8(&emitter, 0xfb);
+    emit8(&emitter, 0x49); emit8(&emitter, 0x89); emit8(&emitter, 0xf4);
+
+    for(int i = 0; i < block->length; i++) {
+        const DecodedInstruction* decoded = &block->instructions[i];
+        if(jit->differential) {
+            emitGameBoyArgument(&emitter);
+            emitCall(&emitter, jitBeginCheck);
+        }
+        if(!emitInline(&emitter, decoded))
+            emitHandlerCall(&emitter, decoded, &operands[i * 2]);
+        if(jit->differential) {
+            // mov esi, edx; call jitEndCheck; mov edx, eax
+            emitGameBoyArgument(&emitter);
+            emit8(&emitter, 0x89); emit8(&emitter, 0xd6);
+            emitCall(&emitter, jitEndCheck);
+            emit8(&emitter, 0x89); emit8(&emitter, 0xc2);
+        }
+        // mov rdi, rbx; mov rsi, r12; mov ecx, nextPC; call jitFinish
+        emitGameBoyArgument(&emitter);
+        emit8(&emitter, 0x4c); emit8(&emitter, 0x89); emit8(&emitter, 0xe6);
+        emit8(&emitter, 0xb9); emit32(&emitter, (i + 1 < block->length) ? block->instructions[i + 1].pc : block->end);
+        emitCall(&emitter, jitFinish);
+        if(i + 1 < block->length) {
+            // test al, al; jz exit
+            emit8(&emitter, 0x84); emit8(&emitter, 0xc0);
+            emit8(&emitter, 0x0f); emit8(&emitter, 0x84);
+            exitJumps[exitJumpCount++] = emitter;
+            emit32(&emitter, 0);
+        }
+    }
+
+    uint8_t* exit = emitter.p;
+    // pop r13; pop r12; pop rbx; ret
+    emit8(&emitter, 0x41); emit8(&emitter, 0x5d);
+    emit8(&emitter, 0x41); emit8(&emitter, 0x5c);
+    emit8(&emitter, 0x5b);
+    emit8(&emitter, 0xc3);
+    if(emitter.overflow)
+        return NULL;
+
+    for(int i = 0; i < exitJumpCount; i++)
+        emit32(&exitJumps[i], (uint32_t) (exit - (exitJumps[i].p + 4)));
+
+    jit->codeUsed = (emitter.p - jit->code + 15) & ~((size_t) 15);
+    jit->compiledBlocks++;
+    return (JitBlockFunction) entry;
+}
+
+static void flushJit(GameBoy* gameBoy) {
+    gameBoy->jit.codeUsed = 0;
+    for(int i = 0; i < BLOCK_CACHE_ENTRIES; i++)
+        gameBoy->blockCache.blocks[i].jitCode = NULL;
+}
+
+bool initJit(Jit* jit, const bool enabled, const bool differential) {
+    jit->enabled = false;
+    jit->differential = differential;
+    jit->code = NULL;
+    jit->codeUsed = 0;
+    jit->before = NULL;
+    jit->after = NULL;
+    jit->compiledBlocks = 0;
+    jit->checkedInstructions = 0;
+    jit->mismatches = 0;
+    if(!enabled)
+        return true;
+
+    void* code = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(code == MAP_FAILED) {
+        fprintf(stderr, "Could not map JIT code buffer, using the interpreter\n");
+        return true;
+    }
+    jit->code = code;
+    if(differential) {
+        jit->before = malloc(sizeof(JitSnapshot));
+        jit->after = malloc(sizeof(JitSnapshot));
+        if((jit->before == NULL) || (jit->after == NULL)) {
+            freeJit(jit);
+            return false;
+        }
+    }
+    jit->enabled = true;
+    return true;
+}
+
+void freeJit(Jit* jit) {
+    if(jit->code != NULL)
+        munmap(jit->code, JIT_CODE_SIZE);
+    free(jit->before);
+    free(jit->after);
+    jit->code = NULL;
+    jit->before = NULL;
+    jit->after = NULL;
+    jit->enabled = false;
+}
+
+JitBlockFunction getJitCode(GameBoy* gameBoy, Block* block) {
+    if(block->jitCode != NULL)
+        return block->jitCode;
+    // RAM code may be rewritten at any time and stays with the interpreter
+    if((block->pc >= 0x8000) || (++block->hits < JIT_HOT_THRESHOLD))
+        return NULL;
+    block->jitCode = compileBlock(gameBoy, block);
+    if(block->jitCode == NULL) {
+        flushJit(gameBoy);
+        block->jitCode = compileBlock(gameBoy, block);
+    }
+    return block->jitCode;
+}
+#else
+bool initJit(Jit* jit, const bool enabled, const bool differential) {
+    jit->enabled = false;
+    jit->differential = differential;
+    jit->code = NULL;
+    jit->codeUsed = 0;
+    jit->before = NULL;
+    jit->after = NULL;
+    jit->compiledBlocks = 0;
+    jit->checkedInstructions = 0;
+    jit->mismatches = 0;
+    if(enabled)
+        fprintf(stderr, "JIT is only available on x86-64, using the interpreter\n");
+    return true;
+}
+
+void freeJit(Jit* jit) {}
+
+JitBlockFunction getJitCode(GameBoy* gameBoy, Block* block) { return NULL; }
+#endif
+
+void printJitStats(Jit* jit) {
+    printf("JIT compiled blocks: %llu\n", (unsigned long long) jit->compiledBlocks);
+    if(jit->differential)
+        printf("JIT checked instructions: %llu, mismatches: %llu\n", (unsigned long long) jit->checkedInstructions, (unsigned long long) jit->mismatches);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct GameBoy GameBoy;
+typedef struct Block Block;
+
+// Entries into a ROM block before it is translated
+#define JIT_HOT_THRESHOLD 8
+#define JIT_CODE_SIZE 0x200000
+
+typedef struct JitContext {
+    int elapsed;
+    int cycles;
+    uint32_t epoch;
+} JitContext;
+
+typedef void (*JitBlockFunction)(GameBoy* gameBoy, JitContext* context);
+
+typedef struct JitSnapshot JitSnapshot;
+
+typedef struct Jit {
+    bool enabled;
+    // Every translated instruction is replayed through decodeAndExecute and the results compared
+    bool differential;
+    uint8_t* code;
+    size_t codeUsed;
+    JitSnapshot* before;
+    JitSnapshot* after;
+    uint64_t compiledBlocks;
+    uint64_t checkedInstructions;
+    uint64_t mismatches;
+} Jit;
+
+bool initJit(Jit* jit, const bool enabled, const bool differential);
+void freeJit(Jit* jit);
+
+JitBlockFunction getJitCode(GameBoy* gameBoy, Block* block);
+void printJitStats(Jit* jit);
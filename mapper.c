@@ -0,0 +1,227 @@
+#include "mapper.h"
+#include <string.h>
+#include "gameboy.h"
+
+#define RTC_SECONDS 0x08
+#define RTC_DAY_HIGH 0x0c
+
+// Bits of each RTC register that exist, the rest read back as 0
+static const uint8_t rtcMasks[5] = { 0x3f, 0x3f, 0x1f, 0xff, 0xc1 };
+
+static void enableRAM(GameBoy* gameBoy, const uint8_t value) {
+    if((value & 0xf) == 0xa)
+        gameBoy->enableRAM = true;
+    else
+        gameBoy->enableRAM = false;
+}
+
+static uint8_t readBankedRAM(GameBoy* gameBoy, const uint16_t address) {
+    if(gameBoy->ramBankBase == NULL)
+        return 0xff;
+    return gameBoy->ramBankBase[address - 0xa000];
+}
+
+static void writeBankedRAM(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    if(!gameBoy->enableRAM || (gameBoy->ramBankBase == NULL))
+        return;
+    gameBoy->ramBankBase[address - 0xa000] = value;
+    markSaveRAMDirty(&gameBoy->saveRAM, &gameBoy->ramBankBase[address - 0xa000]);
+}
+
+static void writeNone(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {}
+
+// The 5 bit register picks bits 0-4 of the ROM bank, the 2 bit one bits 5-6 or, in RAM banking mode, the RAM bank
+static void writeMBC1(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    if(address < 0x2000)
+        enableRAM(gameBoy, value);
+    else if(address < 0x4000) {
+        uint8_t lower = value & 0x1f;
+        if(lower == 0)
+            lower = 1;
+        gameBoy->currentROMBank = (gameBoy->currentROMBank & 0x60) | lower;
+    } else if(address < 0x6000) {
+        gameBoy->currentROMBank = (gameBoy->currentROMBank & 0x1f) | ((value & 0x3) << 5);
+        if(!gameBoy->romBanking)
+            gameBoy->currentRAMBank = value & 0x3;
+    } else {
+        gameBoy->romBanking = (value & 0x1) == 0;
+        gameBoy->currentRAMBank = gameBoy->romBanking ? 0 : ((gameBoy->currentROMBank >> 5) & 0x3);
+    }
+}
+
+// Bit 8 of the address tells RAM enable and ROM bank writes apart
+static void writeMBC2(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    if(address >= 0x4000)
+        return;
+    if((address & 0x100) == 0)
+        enableRAM(gameBoy, value);
+    else {
+        gameBoy->currentROMBank = value & 0xf;
+        if(gameBoy->currentROMBank == 0)
+            gameBoy->currentROMBank = 1;
+    }
+}
+
+// 512 half bytes of RAM built into the MBC, repeated over the whole area
+static uint8_t readMBC2RAM(GameBoy* gameBoy, const uint16_t address) { return gameBoy->saveRAM.data[address & 0x1ff] | 0xf0; }
+
+static void writeMBC2RAM(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    if(!gameBoy->enableRAM)
+        return;
+    gameBoy->saveRAM.data[address & 0x1ff] = value & 0xf;
+    markSaveRAMDirty(&gameBoy->saveRAM, &gameBoy->saveRAM.data[address & 0x1ff]);
+}
+
+static void writeMBC3(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    RTC* rtc = &gameBoy->rtc;
+    if(address < 0x2000)
+        enableRAM(gameBoy, value);
+    else if(address < 0x4000) {
+        gameBoy->currentROMBank = value & 0x7f;
+        if(gameBoy->currentROMBank == 0)
+            gameBoy->currentROMBank = 1;
+    } else if(address < 0x6000) {
+        if(rtc->present && (value >= RTC_SECONDS) && (value <= RTC_DAY_HIGH))
+            rtc->selected = value;
+        else {
+            rtc->selected = 0;
+            gameBoy->currentRAMBank = value & 0x7;
+        }
+    } else {
+        // Writing 0 then 1 copies the running clock into the registers the game reads
+        if(rtc->present && (rtc->lastLatchWrite == 0) && (value == 1))
+            memcpy(rtc->latched, rtc->registers, sizeof(rtc->latched));
+        rtc->lastLatchWrite = value;
+    }
+}
+
+static uint8_t readMBC3RAM(GameBoy* gameBoy, const uint16_t address) {
+    RTC* rtc = &gameBoy->rtc;
+    if(rtc->selected == 0)
+        return readBankedRAM(gameBoy, address);
+    if(!gameBoy->enableRAM)
+        return 0xff;
+    return rtc->latched[rtc->selected - RTC_SECONDS];
+}
+
+static void writeMBC3RAM(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    RTC* rtc = &gameBoy->rtc;
+    if(rtc->selected == 0) {
+        writeBankedRAM(gameBoy, address, value);
+        return;
+    }
+    if(!gameBoy->enableRAM)
+        return;
+    int index = rtc->selected - RTC_SECONDS;
+    rtc->registers[index] = value & rtcMasks[index];
+    rtc->latched[index] = rtc->registers[index];
+    // Writing the seconds restarts the current second
+    if(index == 0)
+        rtc->cycles = 0;
+}
+
+// Nine bit ROM bank where bank 0 is selectable, 4 bit RAM bank
+static void writeMBC5(GameBoy* gameBoy, const uint16_t address, const uint8_t value) {
+    if(address < 0x2000)
+        enableRAM(gameBoy, value);
+    else if(address < 0x3000)
+        gameBoy->currentROMBank = (gameBoy->currentROMBank & 0x100) | value;
+    else if(address < 0x4000)
+        gameBoy->currentROMBank = (gameBoy->currentROMBank & 0xff) | ((value & 0x1) << 8);
+    else if(address < 0x6000)
+        gameBoy->currentRAMBank = value & 0xf;
+}
+
+static const Mapper noMapper = { "ROM", writeNone, readBankedRAM, writeBankedRAM, true, false };
+static const Mapper mbc1 = { "MBC1", writeMBC1, readBankedRAM, writeBankedRAM, true, true };
+static const Mapper mbc2 = { "MBC2", writeMBC2, readMBC2RAM, writeMBC2RAM, false, true };
+static const Mapper mbc3 = { "MBC3", writeMBC3, readMBC3RAM, writeMBC3RAM, true, true };
+static const Mapper mbc5 = { "MBC5", writeMBC5, readBankedRAM, writeBankedRAM, true, true };
+
+// Cartridge type from 0x147 of the header
+const Mapper* getMapper(const uint8_t cartridgeType) {
+    switch(cartridgeType) {
+        case 0x01: case 0x02: case 0x03: return &mbc1;
+        case 0x05: case 0x06: return &mbc2;
+        case 0x0f: case 0x10: case 0x11: case 0x12: case 0x13: return &mbc3;
+        case 0x19: case 0x1a: case 0x1b: case 0x1c: case 0x1d: case 0x1e: return &mbc5;
+        default: return &noMapper;
+    }
+}
+
+bool hasRTC(const uint8_t cartridgeType) { return (cartridgeType == 0x0f) || (cartridgeType == 0x10); }
+
+// Cartridge types whose RAM keeps its contents without power, and so gets a save file
+bool hasBattery(const uint8_t cartridgeType) {
+    switch(cartridgeType) {
+        case 0x03: case 0x06: case 0x09: case 0x0d: case 0x0f: case 0x10: case 0x13: case 0x1b: case 0x1e: case 0xff:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// RAM size from 0x149 of the header, cartridges without RAM still get one bank to keep the area backed
+int getRAMBankCount(const uint8_t ramSize) {
+    switch(ramSize) {
+        case 0x03: return 4;
+        case 0x04: return 16;
+        case 0x05: return 8;
+        default: return 1;
+    }
+}
+
+// Bytes of RAM the cartridge really has, which is what its save file holds. 0x149 of 0x01 is a single
+// 2 KiB chip and MBC2 has 512 half bytes built in while its header says it has none.
+uint32_t getSaveSize(const uint8_t cartridgeType, const uint8_t ramSize) {
+    if(getMapper(cartridgeType) == &mbc2)
+        return 0x200;
+    switch(ramSize) {
+        case 0x01: return 0x800;
+        case 0x02: return RAM_BANK_SIZE;
+        case 0x03: case 0x04: case 0x05: return getRAMBankCount(ramSize) * RAM_BANK_SIZE;
+        default: return 0;
+    }
+}
+
+// Resolves the bank numbers to the host memory behind them, wrapping them to the banks the cartridge has.
+// The RAM area is left to the mapper while it shows an RTC register or is not plain banked RAM.
+void updateBanks(GameBoy* gameBoy) {
+    uint16_t romBank = gameBoy->currentROMBank & (gameBoy->cartridge.romBankCount - 1);
+    gameBoy->romBankBase = &gameBoy->cartridge.data[romBank * ROM_BANK_SIZE];
+    if(!gameBoy->mapper->bankedRAM || (gameBoy->rtc.selected != 0))
+        gameBoy->ramBankBase = NULL;
+    else {
+        uint8_t ramBank = gameBoy->currentRAMBank & (gameBoy->ramBankCount - 1);
+        gameBoy->ramBankBase = &gameBoy->saveRAM.data[ramBank * RAM_BANK_SIZE];
+    }
+}
+
+static bool advanceCounter(uint8_t* counter, const uint8_t limit, const uint8_t mask) {
+    if(++(*counter) == limit) {
+        *counter = 0;
+        return true;
+    }
+    // Out of range values count on until the register overflows, without carrying
+    *counter &= mask;
+    return false;
+}
+
+void tickRTC(GameBoy* gameBoy, const int cycles) {
+    RTC* rtc = &gameBoy->rtc;
+    if(!rtc->present || bit_value(rtc->registers[4], 6))
+        return;
+    rtc->cycles += cycles;
+    while(rtc->cycles >= CYCLES_PER_SECOND) {
+        rtc->cycles -= CYCLES_PER_SECOND;
+        if(!advanceCounter(&rtc->registers[0], 60, 0x3f) || !advanceCounter(&rtc->registers[1], 60, 0x3f) ||
+            !advanceCounter(&rtc->registers[2], 24, 0x1f))
+            continue;
+        uint16_t day = rtc->registers[3] | ((rtc->registers[4] & 0x1) << 8);
+        day = (day + 1) & 0x1ff;
+        rtc->registers[3] = day & 0xff;
+        rtc->registers[4] = (rtc->registers[4] & 0xfe) | (day >> 8);
+        if(day == 0)
+            rtc->registers[4] |= 0x80;
+    }
+}
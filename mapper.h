@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct GameBoy GameBoy;
+
+#define ROM_BANK_SIZE 0x4000
+#define RAM_BANK_SIZE 0x2000
+#define MAX_RAM_BANKS 16
+
+// The clock of MBC3 cartridges, counted in emulated cycles so runs stay deterministic
+typedef struct RTC {
+    bool present;
+    // Seconds, minutes, hours, day counter low, day counter high with the halt and carry flags
+    uint8_t registers[5];
+    uint8_t latched[5];
+    // The register mapped at 0xa000-0xbfff, 0 while a RAM bank is
+    uint8_t selected;
+    uint8_t lastLatchWrite;
+    uint32_t cycles;
+} RTC;
+
+// What a cartridge type does with writes to 0x0000-0x7fff and with its RAM area once that
+// is not plain banked RAM. Writes only change bank numbers, updateBanks then resolves them.
+typedef struct Mapper {
+    const char* name;
+    void (*writeControl)(GameBoy* gameBoy, const uint16_t address, const uint8_t value);
+    uint8_t (*readRAM)(GameBoy* gameBoy, const uint16_t address);
+    void (*writeRAM)(GameBoy* gameBoy, const uint16_t address, const uint8_t value);
+    // Whether the RAM area is plain memory in saveRAM the page tables can point at
+    bool bankedRAM;
+    // Whether RAM only takes writes once 0x0a is written to the enable register. Without an MBC there is no
+    // such register and the RAM is wired straight to the bus.
+    bool gatedRAM;
+} Mapper;
+
+const Mapper* getMapper(const uint8_t cartridgeType);
+bool hasRTC(const uint8_t cartridgeType);
+bool hasBattery(const uint8_t cartridgeType);
+int getRAMBankCount(const uint8_t ramSize);
+uint32_t getSaveSize(const uint8_t cartridgeType, const uint8_t ramSize);
+
+void updateBanks(GameBoy* gameBoy);
+void tickRTC(GameBoy* gameBoy, const int cycles);
@@ -0,0 +1,49 @@
+#include "opcode_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void initOpcodeStats(OpcodeStats* opcodeStats, const bool enabled) {
+    memset(opcodeStats, 0, sizeof(OpcodeStats));
+    opcodeStats->enabled = enabled;
+}
+
+static const OpcodeStats* sortedStats = NULL;
+
+static int compareCycles(const void* first, const void* second) {
+    uint64_t a = sortedStats->cycles[*(const uint16_t*) first];
+    uint64_t b = sortedStats->cycles[*(const uint16_t*) second];
+    return (a < b) - (a > b);
+}
+
+// Every opcode that ran, the ones that consumed the most cycles first
+void printOpcodeStats(OpcodeStats* opcodeStats) {
+    uint16_t order[OPCODE_STATS_ENTRIES];
+    uint64_t totalExecutions = 0;
+    uint64_t totalCycles = 0;
+    for(int i = 0; i < OPCODE_STATS_ENTRIES; i++) {
+        order[i] = i;
+        totalExecutions += opcodeStats->executions[i];
+        totalCycles += opcodeStats->cycles[i];
+    }
+    sortedStats = opcodeStats;
+    qsort(order, OPCODE_STATS_ENTRIES, sizeof(uint16_t), compareCycles);
+
+    printf("%-8s %-20s %14s %14s %7s %14s\n", "Opcode", "Mnemonic", "Executions", "Cycles", "Cycles%", "Branched");
+    for(int i = 0; i < OPCODE_STATS_ENTRIES; i++) {
+        uint16_t index = order[i];
+        if(opcodeStats->executions[index] == 0)
+            break;
+        char opcode[8];
+        if(index >= 0x100)
+            snprintf(opcode, sizeof(opcode), "cb %02x", index & 0xff);
+        else
+            snprintf(opcode, sizeof(opcode), "%02x", index);
+        const char* mnemonic = (index >= 0x100) ? cbInstructionMnemonics[index & 0xff] : instructionMnemonics[index];
+        printf("%-8s %-20s %14llu %14llu %6.2f%% %14llu\n", opcode, mnemonic,
+            (unsigned long long) opcodeStats->executions[index], (unsigned long long) opcodeStats->cycles[index],
+            totalCycles ? (100.0 * opcodeStats->cycles[index]) / totalCycles : 0.0,
+            (unsigned long long) opcodeStats->branched[index]);
+    }
+    printf("%-29s %14llu %14llu\n", "Total", (unsigned long long) totalExecutions, (unsigned long long) totalCycles);
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cpu.h"
+
+// Counters are indexed by opcode, CB prefixed opcodes follow at 0x100
+#define OPCODE_STATS_ENTRIES 0x200
+
+typedef struct OpcodeStats {
+    bool enabled;
+    // The instruction being executed, set when it starts and once more after a CB prefix
+    uint16_t current;
+    uint64_t executions[OPCODE_STATS_ENTRIES];
+    uint64_t cycles[OPCODE_STATS_ENTRIES];
+    // Conditional instructions that took the branch and ran with their branched timing
+    uint64_t branched[OPCODE_STATS_ENTRIES];
+} OpcodeStats;
+
+void initOpcodeStats(OpcodeStats* opcodeStats, const bool enabled);
+
+static inline void countInstruction(OpcodeStats* opcodeStats, const int timing) {
+    uint16_t current = opcodeStats->current;
+    opcodeStats->executions[current]++;
+    opcodeStats->cycles[current] += timing * 4;
+    if((current < 0x100) && (timing != instructionTimings[current]))
+        opcodeStats->branched[current]++;
+}
+
+void printOpcodeStats(OpcodeStats* opcodeStats);
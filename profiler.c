@@ -0,0 +1,216 @@
+#include "profiler.h"
+#include <stdlib.h>
+#include <string.h>
+#include "gameboy.h"
+
+#define PROFILER_CHILDREN (PROFILER_NODES * 2)
+
+static const char* const interruptNames[5] = { "VBlank", "LCD", "Timer", "Serial", "Joypad" };
+
+static int compareSymbols(const void* first, const void* second) {
+    const ProfileSymbol* a = first;
+    const ProfileSymbol* b = second;
+    if(a->bank != b->bank)
+        return a->bank - b->bank;
+    return a->address - b->address;
+}
+
+// RGBDS .sym files hold one "bank:address name" per line, anything else is skipped
+static bool loadSymbols(Profiler* profiler, const char* path) {
+    FILE* file = fopen(path, "r");
+    if(file == NULL)
+        return false;
+    char line[256];
+    char name[256];
+    int capacity = 0;
+    while(fgets(line, sizeof(line), file) != NULL) {
+        unsigned int bank = 0;
+        unsigned int address = 0;
+        if(sscanf(line, "%x:%x %255s", &bank, &address, name) != 3)
+            continue;
+        if(profiler->symbolCount == capacity) {
+            capacity = capacity ? capacity * 2 : 0x400;
+            ProfileSymbol* symbols = realloc(profiler->symbols, capacity * sizeof(ProfileSymbol));
+            if(symbols == NULL) {
+                fclose(file);
+                return false;
+            }
+            profiler->symbols = symbols;
+        }
+        ProfileSymbol* symbol = &profiler->symbols[profiler->symbolCount];
+        symbol->bank = bank;
+        symbol->address = address;
+        symbol->name = strdup(name);
+        if(symbol->name != NULL)
+            profiler->symbolCount++;
+    }
+    fclose(file);
+    qsort(profiler->symbols, profiler->symbolCount, sizeof(ProfileSymbol), compareSymbols);
+    return true;
+}
+
+bool initProfiler(Profiler* profiler, const char* path, const char* symbolPath) {
+    profiler->enabled = false;
+    profiler->file = NULL;
+    profiler->nodes = NULL;
+    profiler->nodeCount = 0;
+    profiler->children = NULL;
+    profiler->current = 0;
+    profiler->depth = 0;
+    profiler->dropped = 0;
+    profiler->symbols = NULL;
+    profiler->symbolCount = 0;
+    if(path == NULL)
+        return true;
+
+    profiler->nodes = calloc(PROFILER_NODES, sizeof(ProfileNode));
+    profiler->children = calloc(PROFILER_CHILDREN, sizeof(uint32_t));
+    profiler->file = fopen(path, "w");
+    if((profiler->nodes == NULL) || (profiler->children == NULL) || (profiler->file == NULL) ||
+        ((symbolPath != NULL) && !loadSymbols(profiler, symbolPath))) {
+        freeProfiler(profiler);
+        return false;
+    }
+    profiler->nodes[0].address = 0x100;
+    profiler->nodeCount = 1;
+    profiler->enabled = true;
+    return true;
+}
+
+void freeProfiler(Profiler* profiler) {
+    if(profiler->file != NULL)
+        fclose(profiler->file);
+    for(int i = 0; i < profiler->symbolCount; i++)
+        free(profiler->symbols[i].name);
+    free(profiler->symbols);
+    free(profiler->nodes);
+    free(profiler->children);
+    profiler->file = NULL;
+    profiler->symbols = NULL;
+    profiler->symbolCount = 0;
+    profiler->nodes = NULL;
+    profiler->children = NULL;
+    profiler->enabled = false;
+}
+
+static uint32_t getChildIndex(const uint32_t parent, const uint16_t bank, const uint16_t address) {
+    uint32_t key = (parent * 0x9e3779b1u) ^ ((((uint32_t) bank << 16) | address) * 0x85ebca6bu);
+    return (key ^ (key >> 15)) & (PROFILER_CHILDREN - 1);
+}
+
+// Returns 0 once the node table is full, the root is never anyone's child
+static uint32_t getChild(Profiler* profiler, const uint16_t bank, const uint16_t address, const bool interrupt) {
+    uint32_t parent = profiler->current;
+    for(uint32_t i = getChildIndex(parent, bank, address); ; i = (i + 1) & (PROFILER_CHILDREN - 1)) {
+        uint32_t entry = profiler->children[i];
+        if(entry == 0)
+            break;
+        ProfileNode* node = &profiler->nodes[entry - 1];
+        if((node->parent == parent) && (node->bank == bank) && (node->address == address))
+            return entry - 1;
+    }
+    if(profiler->nodeCount == PROFILER_NODES)
+        return 0;
+    uint32_t index = profiler->nodeCount++;
+    ProfileNode* node = &profiler->nodes[index];
+    node->parent = parent;
+    node->bank = bank;
+    node->address = address;
+    node->interrupt = interrupt;
+    node->cycles = 0;
+    uint32_t i = getChildIndex(parent, bank, address);
+    while(profiler->children[i] != 0)
+        i = (i + 1) & (PROFILER_CHILDREN - 1);
+    profiler->children[i] = index + 1;
+    return index;
+}
+
+// Leaves every frame whose return address is at or above the top of the stack, so was popped already
+// or is being popped now. Code that drops its return address and jumps away is caught up with this way
+static void unwindFrames(Profiler* profiler, const uint16_t sp) {
+    while((profiler->depth > 0) && (profiler->stack[profiler->depth - 1].sp <= sp))
+        profiler->depth--;
+    profiler->current = profiler->depth ? profiler->stack[profiler->depth - 1].node : 0;
+}
+
+// Called once CALL, RST or an interrupt has pushed the return address and jumped
+void profileCall(GameBoy* gameBoy, const bool interrupt) {
+    Profiler* profiler = &gameBoy->profiler;
+    unwindFrames(profiler, gameBoy->cpu.sp);
+    uint16_t address = gameBoy->cpu.pc;
+    uint16_t bank = ((address >= 0x4000) && (address < 0x8000)) ? gameBoy->currentROMBank : 0;
+    uint32_t node = (profiler->depth < PROFILER_MAX_DEPTH) ? getChild(profiler, bank, address, interrupt) : 0;
+    if(node == 0) {
+        profiler->dropped++;
+        return;
+    }
+    profiler->stack[profiler->depth].node = node;
+    profiler->stack[profiler->depth].sp = gameBoy->cpu.sp;
+    profiler->depth++;
+    profiler->current = node;
+}
+
+// Called by RET and RETI before popping
+void profileReturn(GameBoy* gameBoy) { unwindFrames(&gameBoy->profiler, gameBoy->cpu.sp); }
+
+// The closest symbol at or before the frame in the same bank and 16KB region, NULL if there is none
+static const ProfileSymbol* findSymbol(Profiler* profiler, const ProfileNode* node) {
+    int low = 0;
+    int high = profiler->symbolCount - 1;
+    const ProfileSymbol* found = NULL;
+    while(low <= high) {
+        int middle = (low + high) / 2;
+        const ProfileSymbol* symbol = &profiler->symbols[middle];
+        if((symbol->bank < node->bank) || ((symbol->bank == node->bank) && (symbol->address <= node->address))) {
+            found = symbol;
+            low = middle + 1;
+        } else
+            high = middle - 1;
+    }
+    if((found == NULL) || (found->bank != node->bank) || ((found->address >> 14) != (node->address >> 14)))
+        return NULL;
+    return found;
+}
+
+static void writeFrameName(Profiler* profiler, const uint32_t index) {
+    const ProfileNode* node = &profiler->nodes[index];
+    const ProfileSymbol* symbol = findSymbol(profiler, node);
+    if(index == 0)
+        fputs("main", profiler->file);
+    else if((symbol != NULL) && (symbol->address == node->address))
+        fputs(symbol->name, profiler->file);
+    else if(symbol != NULL)
+        fprintf(profiler->file, "%s+0x%x", symbol->name, node->address - symbol->address);
+    else if(node->interrupt && (node->address >= 0x40) && (node->address <= 0x60))
+        fputs(interruptNames[(node->address - 0x40) / 8], profiler->file);
+    else
+        fprintf(profiler->file, "%02x:%04x", node->bank, node->address);
+}
+
+// One line per call path in the collapsed stack format flamegraph.pl and speedscope read,
+// the frames from the outermost in, separated by semicolons, then the cycles spent in the innermost one
+bool writeProfile(Profiler* profiler) {
+    uint32_t path[PROFILER_MAX_DEPTH + 1];
+    for(uint32_t i = 0; i < profiler->nodeCount; i++) {
+        if(profiler->nodes[i].cycles == 0)
+            continue;
+        int length = 0;
+        for(uint32_t index = i; index != 0; index = profiler->nodes[index].parent)
+            path[length++] = index;
+        path[length++] = 0;
+        while(length > 0) {
+            writeFrameName(profiler, path[--length]);
+            fputc(length ? ';' : ' ', profiler->file);
+        }
+        fprintf(profiler->file, "%llu\n", (unsigned long long) profiler->nodes[i].cycles);
+    }
+    return fflush(profiler->file) == 0;
+}
+
+void printProfilerStats(Profiler* profiler) {
+    uint64_t cycles = 0;
+    for(uint32_t i = 0; i < profiler->nodeCount; i++)
+        cycles += profiler->nodes[i].cycles;
+    printf("Profiled %llu cycles over %u call paths with %d symbols, %llu calls could not be followed\n",
+        (unsigned long long) cycles, profiler->nodeCount, profiler->symbolCount, (unsigned long long) profiler->dropped);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+typedef struct GameBoy GameBoy;
+
+#define PROFILER_NODES 0x10000
+#define PROFILER_MAX_DEPTH 256
+
+// One node per distinct call path, node 0 is the code running outside of any call
+typedef struct ProfileNode {
+    uint32_t parent;
+    uint16_t address;
+    uint16_t bank;
+    bool interrupt;
+    uint64_t cycles;
+} ProfileNode;
+
+// A frame on the shadow call stack, sp is where its return address was pushed
+typedef struct ProfileFrame {
+    uint32_t node;
+    uint16_t sp;
+} ProfileFrame;
+
+typedef struct ProfileSymbol {
+    uint16_t bank;
+    uint16_t address;
+    char* name;
+} ProfileSymbol;
+
+typedef struct Profiler {
+    bool enabled;
+    FILE* file;
+    ProfileNode* nodes;
+    uint32_t nodeCount;
+    // Open addressed, maps (parent, bank, address) to a node index plus one
+    uint32_t* children;
+    uint32_t current;
+    ProfileFrame stack[PROFILER_MAX_DEPTH];
+    int depth;
+    // Calls that could not be followed because the stack or the node table was full
+    uint64_t dropped;
+    ProfileSymbol* symbols;
+    int symbolCount;
+} Profiler;
+
+bool initProfiler(Profiler* profiler, const char* path, const char* symbolPath);
+void freeProfiler(Profiler* profiler);
+
+// Every emulated cycle is charged to the innermost frame
+static inline void profileCycles(Profiler* profiler, const int cycles) { profiler->nodes[profiler->current].cycles += cycles; }
+
+void profileCall(GameBoy* gameBoy, const bool interrupt);
+void profileReturn(GameBoy* gameBoy);
+
+bool writeProfile(Profiler* profiler);
+void printProfilerStats(Profiler* profiler);
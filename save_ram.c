@@ -0,0 +1,142 @@
+#include "save_ram.h"
+#include <stdlib.h>
+#include <string.h>
+#include "gameboy.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define SAVE_RAM_MMAP
+#endif
+
+// The ROM path with its extension replaced by .sav
+static char* getSavePath(const char* romPath) {
+    size_t length = strlen(romPath);
+    const char* slash = strrchr(romPath, '/');
+    const char* dot = strrchr(romPath, '.');
+    if((dot != NULL) && ((slash == NULL) || (dot > slash)))
+        length = dot - romPath;
+    char* path = malloc(length + 5);
+    if(path == NULL)
+        return NULL;
+    memcpy(path, romPath, length);
+    strcpy(&path[length], ".sav");
+    return path;
+}
+
+static void clearDirty(SaveRAM* saveRAM) {
+    memset(saveRAM->dirtyPages, 0, sizeof(saveRAM->dirtyPages));
+    saveRAM->dirtyStart = saveRAM->length;
+    saveRAM->dirtyEnd = 0;
+}
+
+// A save file shorter than the RAM the header asks for is padded with zeros, a longer one is left as it is
+static bool openSaveFile(SaveRAM* saveRAM, const char* path) {
+    saveRAM->file = fopen(path, "r+b");
+    if(saveRAM->file == NULL)
+        saveRAM->file = fopen(path, "w+b");
+    if(saveRAM->file == NULL)
+        return false;
+#ifdef SAVE_RAM_MMAP
+    int descriptor = fileno(saveRAM->file);
+    off_t size = lseek(descriptor, 0, SEEK_END);
+    if((size < (off_t) saveRAM->fileLength) && (ftruncate(descriptor, saveRAM->fileLength) != 0))
+        return false;
+    // Past the end of a smaller file the mapping would fault, 2 KiB and MBC2 saves are read into memory instead
+    if(saveRAM->fileLength == saveRAM->length) {
+        void* data = mmap(NULL, saveRAM->length, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+        if(data != MAP_FAILED) {
+            saveRAM->data = data;
+            saveRAM->mapped = true;
+            return true;
+        }
+    }
+#endif
+    saveRAM->data = calloc(1, saveRAM->length);
+    if(saveRAM->data == NULL)
+        return false;
+    fseek(saveRAM->file, 0, SEEK_SET);
+    fread(saveRAM->data, 1, saveRAM->fileLength, saveRAM->file);
+    return true;
+}
+
+// Cartridges without a battery or without RAM get plain memory, as do battery ones whose save file cannot
+// be opened
+bool initSaveRAM(SaveRAM* saveRAM, const char* romPath, const size_t length, const size_t fileLength, const bool battery) {
+    memset(saveRAM, 0, sizeof(SaveRAM));
+    saveRAM->length = length;
+    saveRAM->fileLength = (fileLength < length) ? fileLength : length;
+    clearDirty(saveRAM);
+    if(battery && (saveRAM->fileLength > 0)) {
+        char* path = getSavePath(romPath);
+        saveRAM->battery = (path != NULL) && openSaveFile(saveRAM, path);
+        if(!saveRAM->battery) {
+            fprintf(stderr, "Could not open save file %s, the game will not be saved\n", path ? path : "");
+            if(saveRAM->file != NULL)
+                fclose(saveRAM->file);
+            saveRAM->file = NULL;
+        }
+        free(path);
+        if(saveRAM->battery)
+            return true;
+    }
+    saveRAM->data = calloc(1, length);
+    return saveRAM->data != NULL;
+}
+
+// Hands the dirty range to the file, waiting for it to reach the disk only when asked to
+static bool writeDirty(SaveRAM* saveRAM, const bool wait) {
+    if(!saveRAM->battery || (saveRAM->dirtyStart >= saveRAM->dirtyEnd))
+        return false;
+#ifdef SAVE_RAM_MMAP
+    if(saveRAM->mapped) {
+        size_t hostPage = sysconf(_SC_PAGESIZE);
+        size_t start = saveRAM->dirtyStart & ~(hostPage - 1);
+        msync(&saveRAM->data[start], saveRAM->dirtyEnd - start, wait ? MS_SYNC : MS_ASYNC);
+        clearDirty(saveRAM);
+        return true;
+    }
+#endif
+    // Writes to the part of data the cartridge does not have stay out of the file
+    size_t end = (saveRAM->dirtyEnd < saveRAM->fileLength) ? saveRAM->dirtyEnd : saveRAM->fileLength;
+    if(saveRAM->dirtyStart < end) {
+        fseek(saveRAM->file, saveRAM->dirtyStart, SEEK_SET);
+        fwrite(&saveRAM->data[saveRAM->dirtyStart], 1, end - saveRAM->dirtyStart, saveRAM->file);
+        fflush(saveRAM->file);
+    }
+    clearDirty(saveRAM);
+    return true;
+}
+
+void freeSaveRAM(SaveRAM* saveRAM) {
+    writeDirty(saveRAM, true);
+#ifdef SAVE_RAM_MMAP
+    if(saveRAM->mapped)
+        munmap(saveRAM->data, saveRAM->length);
+    else
+#endif
+    free(saveRAM->data);
+    if(saveRAM->file != NULL)
+        fclose(saveRAM->file);
+    saveRAM->data = NULL;
+    saveRAM->file = NULL;
+}
+
+// The flushed pages are write protected again so the next write to them marks them dirty
+void flushSaveRAM(GameBoy* gameBoy) {
+    if(!writeDirty(&gameBoy->saveRAM, false))
+        return;
+    for(int page = 0xa0; page < 0xc0; page++)
+        mapPage(gameBoy, page);
+}
+
+void tickSaveRAM(GameBoy* gameBoy, const int cycles) {
+    SaveRAM* saveRAM = &gameBoy->saveRAM;
+    if(!saveRAM->battery)
+        return;
+    saveRAM->cycles += cycles;
+    if(saveRAM->cycles < SAVE_FLUSH_CYCLES)
+        return;
+    saveRAM->cycles = 0;
+    flushSaveRAM(gameBoy);
+}
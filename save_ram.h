@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "mapper.h"
+
+typedef struct GameBoy GameBoy;
+
+#define SAVE_PAGE_SIZE 0x100
+// Emulated cycles between flushes of dirty battery RAM, about a second
+#define SAVE_FLUSH_CYCLES 4194304
+
+// External RAM. Battery backed cartridges keep it in the .sav file next to the ROM, mapped shared
+// so stores land in the file when it covers all of data. Pages stay write protected in the page tables until a write marks them
+// dirty, flushSaveRAM writes the dirty ones back and protects them again.
+typedef struct SaveRAM {
+    uint8_t* data;
+    // At least a bank so the page tables and the bank masking have something behind them
+    size_t length;
+    // What the .sav file holds, the RAM the header says the cartridge has and no more than length
+    size_t fileLength;
+    bool battery;
+    bool mapped;
+    FILE* file;
+    // One flag per 256 byte page of data, and the byte range they cover
+    bool dirtyPages[MAX_RAM_BANKS * RAM_BANK_SIZE / SAVE_PAGE_SIZE];
+    size_t dirtyStart;
+    size_t dirtyEnd;
+    uint32_t cycles;
+} SaveRAM;
+
+bool initSaveRAM(SaveRAM* saveRAM, const char* romPath, const size_t length, const size_t fileLength, const bool battery);
+void freeSaveRAM(SaveRAM* saveRAM);
+
+void flushSaveRAM(GameBoy* gameBoy);
+void tickSaveRAM(GameBoy* gameBoy, const int cycles);
+
+// Whether stores to the page holding target can bypass the handler
+static inline bool isSaveRAMWritable(const SaveRAM* saveRAM, const uint8_t* target) {
+    return !saveRAM->battery || saveRAM->dirtyPages[(target - saveRAM->data) / SAVE_PAGE_SIZE];
+}
+
+static inline void markSaveRAMDirty(SaveRAM* saveRAM, const uint8_t* target) {
+    if(!saveRAM->battery)
+        return;
+    size_t offset = target - saveRAM->data;
+    saveRAM->dirtyPages[offset / SAVE_PAGE_SIZE] = true;
+    size_t start = offset & ~(size_t) (SAVE_PAGE_SIZE - 1);
+    if(start < saveRAM->dirtyStart)
+        saveRAM->dirtyStart = start;
+    if(start + SAVE_PAGE_SIZE > saveRAM->dirtyEnd)
+        saveRAM->dirtyEnd = start + SAVE_PAGE_SIZE;
+}
@@ -0,0 +1,49 @@
+#include "scheduler.h"
+#include "gameboy.h"
+
+typedef void (*EventHandler)(GameBoy* gameBoy, const uint64_t deadline);
+
+static const EventHandler eventHandlers[EVENT_COUNT] = {
+    [EVENT_LCD_MODE] = lcdModeEvent,
+    [EVENT_LINE] = lineEvent,
+    [EVENT_TIMER] = timerEvent,
+    [EVENT_DMA] = dmaEvent,
+    [EVENT_SERIAL] = serialEvent
+};
+
+void initScheduler(Scheduler* scheduler) {
+    scheduler->cycles = 0;
+    for(int i = 0; i < EVENT_COUNT; i++)
+        scheduler->deadlines[i] = NEVER;
+    scheduler->nextEvent = NEVER;
+}
+
+uint64_t getEarliestEvent(const Scheduler* scheduler, const Event ignored) {
+    uint64_t earliest = NEVER;
+    for(int i = 0; i < EVENT_COUNT; i++)
+        if((i != ignored) && (scheduler->deadlines[i] < earliest))
+            earliest = scheduler->deadlines[i];
+    return earliest;
+}
+
+void scheduleEvent(Scheduler* scheduler, const Event event, const uint64_t deadline) {
+    scheduler->deadlines[event] = deadline;
+    scheduler->nextEvent = getEarliestEvent(scheduler, EVENT_COUNT);
+}
+
+void cancelEvent(Scheduler* scheduler, const Event event) { scheduleEvent(scheduler, event, NEVER); }
+
+// Fires everything due in deadline order, events sharing a deadline in the order of the enum. A handler is
+// passed the deadline it was due at rather than the current count, so periodic events do not drift.
+void runEvents(GameBoy* gameBoy) {
+    Scheduler* scheduler = &gameBoy->scheduler;
+    while(scheduler->nextEvent <= scheduler->cycles) {
+        int event = 0;
+        for(int i = 1; i < EVENT_COUNT; i++)
+            if(scheduler->deadlines[i] < scheduler->deadlines[event])
+                event = i;
+        uint64_t deadline = scheduler->deadlines[event];
+        cancelEvent(scheduler, event);
+        eventHandlers[event](gameBoy, deadline);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct GameBoy GameBoy;
+
+// Deadline of an event that is not scheduled
+#define NEVER UINT64_MAX
+
+typedef enum Event {
+    // Mode 2 to 3 and 3 to 0 within a visible line
+    EVENT_LCD_MODE,
+    // LY moves on to the next line
+    EVENT_LINE,
+    // TIMA overflows and reloads from TMA
+    EVENT_TIMER,
+    // An accurate OAM DMA moves its next byte
+    EVENT_DMA,
+    // A transfer clocked by the Game Boy has shifted out its 8 bits
+    EVENT_SERIAL,
+    EVENT_COUNT
+} Event;
+
+// The hardware that changes on its own does so at deadlines on a single cycle count rather than counting down
+// after every instruction. updateHardware only moves the count on and calls runEvents once it reaches the
+// earliest deadline, the CPU runs freely until then. Each event schedules the next one when it fires, register
+// writes that change when it is due reschedule it.
+typedef struct Scheduler {
+    uint64_t cycles;
+    uint64_t nextEvent;
+    uint64_t deadlines[EVENT_COUNT];
+} Scheduler;
+
+void initScheduler(Scheduler* scheduler);
+void scheduleEvent(Scheduler* scheduler, const Event event, const uint64_t deadline);
+void cancelEvent(Scheduler* scheduler, const Event event);
+// The earliest deadline leaving out ignored, EVENT_COUNT leaves out nothing
+uint64_t getEarliestEvent(const Scheduler* scheduler, const Event ignored);
+
+void runEvents(GameBoy* gameBoy);
@@ -0,0 +1,109 @@
+#include "trace.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include "gameboy.h"
+
+// Drains the ring buffer in as few writes as possible, and once stopped until it is empty
+static void* writeTrace(void* argument) {
+    Trace* trace = argument;
+    while(true) {
+        bool stopping = !atomic_load_explicit(&trace->running, memory_order_acquire);
+        uint64_t tail = atomic_load_explicit(&trace->tail, memory_order_relaxed);
+        uint64_t head = atomic_load_explicit(&trace->head, memory_order_acquire);
+        if(head == tail) {
+            if(stopping)
+                return NULL;
+            struct timespec wait = { 0, 1000000 };
+            nanosleep(&wait, NULL);
+            continue;
+        }
+        uint32_t start = tail & (TRACE_BUFFER_RECORDS - 1);
+        uint64_t count = head - tail;
+        if(start + count > TRACE_BUFFER_RECORDS)
+            count = TRACE_BUFFER_RECORDS - start;
+        fwrite(&trace->records[start], sizeof(TraceRecord), count, trace->file);
+        atomic_store_explicit(&trace->tail, tail + count, memory_order_release);
+    }
+}
+
+bool initTrace(Trace* trace, const char* path) {
+    trace->enabled = false;
+    trace->cycles = 0;
+    trace->file = NULL;
+    trace->records = NULL;
+    atomic_init(&trace->head, 0);
+    atomic_init(&trace->tail, 0);
+    atomic_init(&trace->running, false);
+    trace->stalls = 0;
+    if(path == NULL)
+        return true;
+
+    trace->records = malloc(TRACE_BUFFER_RECORDS * sizeof(TraceRecord));
+    trace->file = fopen(path, "wb");
+    if((trace->records == NULL) || (trace->file == NULL)) {
+        freeTrace(trace);
+        return false;
+    }
+    fwrite(TRACE_MAGIC, 1, strlen(TRACE_MAGIC), trace->file);
+    atomic_store(&trace->running, true);
+    if(pthread_create(&trace->writer, NULL, writeTrace, trace) != 0) {
+        atomic_store(&trace->running, false);
+        freeTrace(trace);
+        return false;
+    }
+    trace->enabled = true;
+    return true;
+}
+
+void freeTrace(Trace* trace) {
+    if(atomic_load(&trace->running)) {
+        atomic_store_explicit(&trace->running, false, memory_order_release);
+        pthread_join(trace->writer, NULL);
+    }
+    if(trace->file != NULL)
+        fclose(trace->file);
+    free(trace->records);
+    trace->file = NULL;
+    trace->records = NULL;
+    trace->enabled = false;
+}
+
+// Called before the instruction at cpu.pc executes
+void traceInstruction(GameBoy* gameBoy, const uint64_t cycle, const uint8_t opcode, const uint8_t* operands) {
+    Trace* trace = &gameBoy->trace;
+    uint64_t head = atomic_load_explicit(&trace->head, memory_order_relaxed);
+    if(head - atomic_load_explicit(&trace->tail, memory_order_acquire) >= TRACE_BUFFER_RECORDS) {
+        trace->stalls++;
+        while(head - atomic_load_explicit(&trace->tail, memory_order_acquire) >= TRACE_BUFFER_RECORDS)
+            sched_yield();
+    }
+
+    CPU* cpu = &gameBoy->cpu;
+    TraceRecord* record = &trace->records[head & (TRACE_BUFFER_RECORDS - 1)];
+    record->cycle = cycle;
+    record->pc = cpu->pc;
+    record->sp = cpu->sp;
+    record->bc = cpu->bc;
+    record->de = cpu->de;
+    record->hl = cpu->hl;
+    record->a = cpu->a;
+    record->f = getFFlagsAsByte(cpu);
+    record->opcode = opcode;
+    for(int i = 0; i < 2; i++) {
+        if(i >= instructionLengths[opcode] - 1)
+            record->operands[i] = 0;
+        else
+            record->operands[i] = operands ? operands[i] : peekMemory(gameBoy, cpu->pc + 1 + i);
+    }
+    record->reserved = 0;
+    record->bank = gameBoy->currentROMBank;
+    memset(record->padding, 0, sizeof(record->padding));
+    atomic_store_explicit(&trace->head, head + 1, memory_order_release);
+}
+
+void printTraceStats(Trace* trace) {
+    printf("Traced %llu instructions, the CPU waited on the writer %llu times\n",
+        (unsigned long long) atomic_load(&trace->head), (unsigned long long) trace->stalls);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+typedef struct GameBoy GameBoy;
+
+// A trace file is TRACE_MAGIC followed by one 32 byte TraceRecord per executed instruction, in host byte order:
+//   0  cycle      8 bytes
+//   8  pc, sp, bc, de, hl, 2 bytes each
+//  18  a, f, opcode, operands[0], operands[1], 1 byte each, operands the instruction does not have are 0
+//  23  1 reserved byte, always 0
+//  24  ROM bank  2 bytes
+//  26  6 reserved bytes, always 0
+#define TRACE_MAGIC "PGBETRC2"
+#define TRACE_BUFFER_RECORDS 0x10000
+
+// The padding is spelled out and cleared so no heap bytes end up in the file
+typedef struct TraceRecord {
+    uint64_t cycle;
+    uint16_t pc;
+    uint16_t sp;
+    uint16_t bc;
+    uint16_t de;
+    uint16_t hl;
+    uint8_t a;
+    uint8_t f;
+    uint8_t opcode;
+    uint8_t operands[2];
+    uint8_t reserved;
+    uint16_t bank;
+    uint8_t padding[6];
+} TraceRecord;
+
+_Static_assert(sizeof(TraceRecord) == 32, "TraceRecord has padding the file layout does not account for");
+
+typedef struct Trace {
+    bool enabled;
+    // Cycles run by earlier runCPU calls, records are stamped with this plus the cycles elapsed in the current one
+    uint64_t cycles;
+    FILE* file;
+    TraceRecord* records;
+    // The CPU only ever moves head and the writer thread only ever moves tail
+    _Atomic uint64_t head;
+    _Atomic uint64_t tail;
+    atomic_bool running;
+    pthread_t writer;
+    uint64_t stalls;
+} Trace;
+
+bool initTrace(Trace* trace, const char* path);
+void freeTrace(Trace* trace);
+
+void traceInstruction(GameBoy* gameBoy, const uint64_t cycle, const uint8_t opcode, const uint8_t* operands);
+void printTraceStats(Trace* trace);